@@ -0,0 +1,613 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#include "allocator.h"
+
+// Every block is aligned for any type, as malloc does
+#define ALLOCATOR_ALIGNMENT _Alignof(max_align_t)
+
+static size_t _allocator_align(size_t bytes)
+{
+    return (bytes + ALLOCATOR_ALIGNMENT - 1) & ~(size_t)(ALLOCATOR_ALIGNMENT - 1);
+}
+
+// System
+// Small blocks come from malloc and grow with realloc. Blocks of at least
+// ARRAY_MAP_THRESHOLD bytes are mapped straight from the kernel and grow with
+// mremap, which moves page table entries instead of copying the contents.
+// Which kind a block is follows from its size alone.
+static size_t _system_pageSize(void)
+{
+    static size_t pageSize = 0;
+    if (pageSize == 0)
+    {
+        pageSize = sysconf(_SC_PAGESIZE);
+    }
+    return pageSize;
+}
+
+static int _system_isMapped(size_t bytes)
+{
+#ifdef __linux__
+    return bytes >= ARRAY_MAP_THRESHOLD;
+#else
+    return 0;
+#endif
+}
+
+// Mapped blocks always fill whole pages
+static size_t _system_usable(Allocator *self, size_t bytes)
+{
+    (void)self;
+    if (!_system_isMapped(bytes))
+    {
+        return bytes;
+    }
+    size_t pageSize = _system_pageSize();
+    return (bytes + pageSize - 1) / pageSize * pageSize;
+}
+
+static void *_system_allocate(Allocator *self, size_t bytes)
+{
+    (void)self;
+    if (!_system_isMapped(bytes))
+    {
+        return malloc(bytes);
+    }
+    void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return data == MAP_FAILED ? NULL : data;
+}
+
+static void _system_release(Allocator *self, void *data, size_t bytes)
+{
+    (void)self;
+    if (_system_isMapped(bytes))
+    {
+        munmap(data, bytes);
+    }
+    else
+    {
+        free(data);
+    }
+}
+
+static void *_system_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    if (!_system_isMapped(newBytes) && !_system_isMapped(bytes))
+    {
+        return realloc(data, newBytes);
+    }
+#ifdef __linux__
+    if (_system_isMapped(newBytes) && _system_isMapped(bytes))
+    {
+        void *moved = mremap(data, bytes, newBytes, MREMAP_MAYMOVE);
+        return moved == MAP_FAILED ? NULL : moved;
+    }
+#endif
+    // Crossing between malloc and a mapping needs a copy
+    keep = keep < newBytes ? keep : newBytes;
+    void *newData = _system_allocate(self, newBytes);
+    if (newData != NULL)
+    {
+        memcpy(newData, data, keep);
+        _system_release(self, data, bytes);
+    }
+    return newData;
+}
+
+Allocator *allocator_system(void)
+{
+    static Allocator system = {"system", _system_allocate, _system_resize, _system_release, _system_usable};
+    return &system;
+}
+
+// Arena
+static size_t _arena_usable(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return _allocator_align(bytes);
+}
+
+static void *_arena_allocate(Allocator *self, size_t bytes)
+{
+    ArenaAllocator *arena = (ArenaAllocator *)self;
+    bytes = _allocator_align(bytes);
+    if (bytes > arena->size - arena->used)
+    {
+        return NULL;
+    }
+    arena->last = arena->memory + arena->used;
+    arena->used += bytes;
+    return arena->last;
+}
+
+static void *_arena_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    ArenaAllocator *arena = (ArenaAllocator *)self;
+    if (data == arena->last)
+    {
+        // The newest block can simply be extended
+        size_t start = arena->last - arena->memory;
+        if (_allocator_align(newBytes) > arena->size - start)
+        {
+            return NULL;
+        }
+        arena->used = start + _allocator_align(newBytes);
+        return data;
+    }
+    if (newBytes <= bytes)
+    {
+        return data;
+    }
+    void *newData = _arena_allocate(self, newBytes);
+    if (newData != NULL)
+    {
+        memcpy(newData, data, keep);
+    }
+    return newData;
+}
+
+static void _arena_release(Allocator *self, void *data, size_t bytes)
+{
+    ArenaAllocator *arena = (ArenaAllocator *)self;
+    (void)bytes;
+    if (data == arena->last)
+    {
+        arena->used = arena->last - arena->memory;
+        arena->last = NULL;
+    }
+}
+
+void arena_init(ArenaAllocator *arena, void *memory, size_t size)
+{
+    // Start on an aligned address, losing at most a few bytes of the buffer
+    size_t skip = _allocator_align((uintptr_t)memory) - (uintptr_t)memory;
+    assert(skip <= size);
+    arena->base = (Allocator){"arena", _arena_allocate, _arena_resize, _arena_release, _arena_usable};
+    arena->memory = (char *)memory + skip;
+    arena->size = size - skip;
+    arena_reset(arena);
+}
+
+void arena_reset(ArenaAllocator *arena)
+{
+    arena->used = 0;
+    arena->last = NULL;
+}
+
+// Pool
+static size_t _pool_usable(Allocator *self, size_t bytes)
+{
+    PoolAllocator *pool = (PoolAllocator *)self;
+    return bytes <= pool->blockSize ? pool->blockSize : bytes;
+}
+
+static void *_pool_allocate(Allocator *self, size_t bytes)
+{
+    PoolAllocator *pool = (PoolAllocator *)self;
+    if (bytes > pool->blockSize || pool->freeList == NULL)
+    {
+        return NULL;
+    }
+    void *block = pool->freeList;
+    pool->freeList = *(void **)block;
+    pool->freeBlocks--;
+    return block;
+}
+
+// Every block already has blockSize bytes, so a resize either fits or fails
+static void *_pool_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    PoolAllocator *pool = (PoolAllocator *)self;
+    (void)bytes;
+    (void)keep;
+    return newBytes <= pool->blockSize ? data : NULL;
+}
+
+static void _pool_release(Allocator *self, void *data, size_t bytes)
+{
+    PoolAllocator *pool = (PoolAllocator *)self;
+    (void)bytes;
+    *(void **)data = pool->freeList;
+    pool->freeList = data;
+    pool->freeBlocks++;
+}
+
+void pool_init(PoolAllocator *pool, void *memory, size_t blockSize, size_t blocks)
+{
+    assert(((uintptr_t)memory & (ALLOCATOR_ALIGNMENT - 1)) == 0);
+    blockSize = _allocator_align(blockSize < sizeof(void *) ? sizeof(void *) : blockSize);
+    pool->base = (Allocator){"pool", _pool_allocate, _pool_resize, _pool_release, _pool_usable};
+    pool->blockSize = blockSize;
+    pool->freeList = NULL;
+    pool->freeBlocks = 0;
+
+    // Thread the free list through the blocks, lowest address first
+    for (size_t i = blocks; i > 0; i--)
+    {
+        _pool_release(&pool->base, (char *)memory + (i - 1) * blockSize, blockSize);
+    }
+}
+
+// Size classes
+#define ALLOCATOR_SMALLEST_CLASS ((size_t)16)
+#define ALLOCATOR_LARGEST_CLASS (ALLOCATOR_SMALLEST_CLASS << (ALLOCATOR_SIZE_CLASSES - 1))
+
+static int _sizeclass_class(size_t bytes)
+{
+    int c = 0;
+    while ((ALLOCATOR_SMALLEST_CLASS << c) < bytes)
+    {
+        c++;
+    }
+    return c;
+}
+
+static size_t _sizeclass_usable(Allocator *self, size_t bytes)
+{
+    if (bytes > ALLOCATOR_LARGEST_CLASS)
+    {
+        return _system_usable(self, bytes);
+    }
+    return ALLOCATOR_SMALLEST_CLASS << _sizeclass_class(bytes);
+}
+
+static void *_sizeclass_allocate(Allocator *self, size_t bytes)
+{
+    SizeClassAllocator *sizeClass = (SizeClassAllocator *)self;
+    if (bytes > ALLOCATOR_LARGEST_CLASS)
+    {
+        return _system_allocate(self, bytes);
+    }
+    int c = _sizeclass_class(bytes);
+    void *block = sizeClass->freeLists[c];
+    if (block == NULL)
+    {
+        return _arena_allocate(&sizeClass->arena.base, ALLOCATOR_SMALLEST_CLASS << c);
+    }
+    sizeClass->freeLists[c] = *(void **)block;
+    return block;
+}
+
+static void _sizeclass_release(Allocator *self, void *data, size_t bytes)
+{
+    SizeClassAllocator *sizeClass = (SizeClassAllocator *)self;
+    if (bytes > ALLOCATOR_LARGEST_CLASS)
+    {
+        _system_release(self, data, bytes);
+        return;
+    }
+    int c = _sizeclass_class(bytes);
+    *(void **)data = sizeClass->freeLists[c];
+    sizeClass->freeLists[c] = data;
+}
+
+static void *_sizeclass_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    if (bytes > ALLOCATOR_LARGEST_CLASS && newBytes > ALLOCATOR_LARGEST_CLASS)
+    {
+        return _system_resize(self, data, bytes, newBytes, keep);
+    }
+    if (_sizeclass_usable(self, bytes) == _sizeclass_usable(self, newBytes))
+    {
+        return data;
+    }
+    keep = keep < newBytes ? keep : newBytes;
+    void *newData = _sizeclass_allocate(self, newBytes);
+    if (newData != NULL)
+    {
+        memcpy(newData, data, keep);
+        _sizeclass_release(self, data, bytes);
+    }
+    return newData;
+}
+
+void sizeclass_init(SizeClassAllocator *sizeClass, void *memory, size_t size)
+{
+    sizeClass->base = (Allocator){"sizeclass", _sizeclass_allocate, _sizeclass_resize, _sizeclass_release,
+                                  _sizeclass_usable};
+    arena_init(&sizeClass->arena, memory, size);
+    for (int c = 0; c < ALLOCATOR_SIZE_CLASSES; c++)
+    {
+        sizeClass->freeLists[c] = NULL;
+    }
+}
+
+// Realtime
+#define ALLOCATOR_HUGEPAGE_SIZE (2UL * 1024 * 1024)
+
+static size_t _realtime_usable(Allocator *self, size_t bytes)
+{
+    RealtimeAllocator *realtime = (RealtimeAllocator *)self;
+    size_t granule = realtime->flags & (ALLOCATOR_HUGEPAGES | ALLOCATOR_HUGETLB) ? ALLOCATOR_HUGEPAGE_SIZE
+                                                                                 : _system_pageSize();
+    return (bytes + granule - 1) / granule * granule;
+}
+
+// Commit [from, to) of a block now instead of on first access. The pages are
+// written, reading them would only map the shared zero page.
+static void _realtime_setup(RealtimeAllocator *realtime, char *data, size_t from, size_t to)
+{
+    // Placement first, so the prefault already puts the pages on the right node
+    if ((realtime->flags & (ALLOCATOR_INTERLEAVE | ALLOCATOR_BIND)) &&
+        allocator_place(data + from, to - from, realtime->flags, realtime->node) != 0)
+    {
+        realtime->placeFailures++;
+    }
+#ifdef __linux__
+    if (realtime->flags & ALLOCATOR_HUGEPAGES)
+    {
+        madvise(data + from, to - from, MADV_HUGEPAGE);
+    }
+#endif
+    if (realtime->flags & ALLOCATOR_PREFAULT)
+    {
+        size_t pageSize = _system_pageSize();
+        for (volatile char *page = data + from; page < data + to; page += pageSize)
+        {
+            *page = 0;
+        }
+    }
+    if ((realtime->flags & ALLOCATOR_LOCK) && mlock(data + from, to - from) != 0)
+    {
+        realtime->lockFailures++;
+    }
+}
+
+static void *_realtime_map(RealtimeAllocator *realtime, size_t bytes)
+{
+    char *data;
+#ifdef __linux__
+    if (realtime->flags & ALLOCATOR_HUGETLB)
+    {
+        data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        return data == MAP_FAILED ? NULL : data;
+    }
+#endif
+    if (!(realtime->flags & ALLOCATOR_HUGEPAGES))
+    {
+        data = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return data == MAP_FAILED ? NULL : data;
+    }
+
+    // Transparent hugepages need a 2 MB aligned block, map more and trim both ends
+    size_t padded = bytes + ALLOCATOR_HUGEPAGE_SIZE;
+    char *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return NULL;
+    }
+    data = (char *)(((uintptr_t)raw + ALLOCATOR_HUGEPAGE_SIZE - 1) & ~(uintptr_t)(ALLOCATOR_HUGEPAGE_SIZE - 1));
+    if (data > raw)
+    {
+        munmap(raw, data - raw);
+    }
+    munmap(data + bytes, raw + padded - (data + bytes));
+    return data;
+}
+
+static void *_realtime_allocate(Allocator *self, size_t bytes)
+{
+    RealtimeAllocator *realtime = (RealtimeAllocator *)self;
+    bytes = _realtime_usable(self, bytes);
+    char *data = _realtime_map(realtime, bytes);
+    if (data != NULL)
+    {
+        _realtime_setup(realtime, data, 0, bytes);
+    }
+    return data;
+}
+
+static void _realtime_release(Allocator *self, void *data, size_t bytes)
+{
+    munmap(data, _realtime_usable(self, bytes));
+}
+
+static void *_realtime_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    RealtimeAllocator *realtime = (RealtimeAllocator *)self;
+    bytes = _realtime_usable(self, bytes);
+    newBytes = _realtime_usable(self, newBytes);
+#ifdef __linux__
+    // The pages already there stay committed and locked wherever mremap puts them
+    char *moved = mremap(data, bytes, newBytes, MREMAP_MAYMOVE);
+    if (moved != MAP_FAILED)
+    {
+        if (newBytes > bytes)
+        {
+            _realtime_setup(realtime, moved, bytes, newBytes);
+        }
+        return moved;
+    }
+#endif
+    void *newData = _realtime_allocate(self, newBytes);
+    if (newData != NULL)
+    {
+        memcpy(newData, data, keep);
+        _realtime_release(self, data, bytes);
+    }
+    return newData;
+}
+
+void realtime_init(RealtimeAllocator *realtime, unsigned flags)
+{
+    realtime->base = (Allocator){"realtime", _realtime_allocate, _realtime_resize, _realtime_release, _realtime_usable};
+    realtime->flags = flags;
+    realtime->node = 0;
+    realtime->lockFailures = 0;
+    realtime->placeFailures = 0;
+}
+
+// NUMA
+int allocator_numaNodes(void)
+{
+    static int nodes = 0;
+    if (nodes > 0)
+    {
+        return nodes;
+    }
+
+    // A list like "0" or "0-1,4-5", the highest number in it is the last node
+    nodes = 1;
+    FILE *f = fopen("/sys/devices/system/node/has_memory", "r");
+    if (f != NULL)
+    {
+        char list[256];
+        if (fgets(list, sizeof(list), f) != NULL)
+        {
+            for (char *p = list; *p != '\0';)
+            {
+                char *end;
+                long node = strtol(p, &end, 10);
+                if (end == p)
+                {
+                    p++;
+                    continue;
+                }
+                nodes = node + 1 > nodes ? node + 1 : nodes;
+                p = end;
+            }
+        }
+        fclose(f);
+    }
+    return nodes;
+}
+
+int allocator_place(void *data, size_t bytes, unsigned policy, int node)
+{
+#ifdef __linux__
+    int nodes = allocator_numaNodes();
+    unsigned long mask;
+    if (node < 0 || node >= nodes || nodes > (int)sizeof(mask) * 8)
+    {
+        return -1;
+    }
+    mask = policy & ALLOCATOR_BIND ? 1UL << node : nodes == (int)sizeof(mask) * 8 ? ~0UL : (1UL << nodes) - 1;
+    int mode = policy & ALLOCATOR_BIND ? MPOL_BIND : MPOL_INTERLEAVE;
+
+    // mbind works on whole pages
+    uintptr_t start = (uintptr_t)data & ~(uintptr_t)(_system_pageSize() - 1);
+    bytes += (uintptr_t)data - start;
+    return syscall(SYS_mbind, start, bytes, mode, &mask, sizeof(mask) * 8 + 1, MPOL_MF_MOVE) == 0 ? 0 : -1;
+#else
+    (void)data;
+    (void)bytes;
+    (void)policy;
+    (void)node;
+    return -1;
+#endif
+}
+
+// File
+static size_t _file_usable(Allocator *self, size_t bytes)
+{
+    FileAllocator *file = (FileAllocator *)self;
+    size_t pageSize = _system_pageSize();
+    return (file->header + bytes + pageSize - 1) / pageSize * pageSize - file->header;
+}
+
+static void *_file_allocate(Allocator *self, size_t bytes)
+{
+    FileAllocator *file = (FileAllocator *)self;
+    size_t total = file->header + _file_usable(self, bytes);
+    assert(file->mapping == NULL);
+
+    if (file->writable && file->header + file_allocator_size(file) < total && ftruncate(file->fd, total) != 0)
+    {
+        return NULL;
+    }
+    int prot = file->writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    void *mapping = mmap(NULL, total, prot, MAP_SHARED, file->fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        return NULL;
+    }
+    file->mapping = mapping;
+    file->mappedBytes = total;
+    return file->mapping + file->header;
+}
+
+static void *_file_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    FileAllocator *file = (FileAllocator *)self;
+    size_t total = file->header + _file_usable(self, newBytes);
+    (void)data;
+    (void)bytes;
+    (void)keep;
+
+    // Growing the file keeps the contents, only the mapping has to follow
+    if (!file->writable || ftruncate(file->fd, total) != 0)
+    {
+        return NULL;
+    }
+#ifdef __linux__
+    void *moved = mremap(file->mapping, file->mappedBytes, total, MREMAP_MAYMOVE);
+#else
+    munmap(file->mapping, file->mappedBytes);
+    void *moved = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+#endif
+    if (moved == MAP_FAILED)
+    {
+        return NULL;
+    }
+    file->mapping = moved;
+    file->mappedBytes = total;
+    return file->mapping + file->header;
+}
+
+static void _file_release(Allocator *self, void *data, size_t bytes)
+{
+    FileAllocator *file = (FileAllocator *)self;
+    (void)data;
+    (void)bytes;
+    if (file->mapping != NULL)
+    {
+        munmap(file->mapping, file->mappedBytes);
+    }
+    close(file->fd);
+    free(file);
+}
+
+FileAllocator *file_allocator_open(const char *path, int writable, size_t header)
+{
+    int fd = open(path, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+    FileAllocator *file = malloc(sizeof(FileAllocator));
+    if (file == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+    file->base = (Allocator){"file", _file_allocate, _file_resize, _file_release, _file_usable};
+    file->fd = fd;
+    file->writable = writable;
+    file->header = header;
+    file->mapping = NULL;
+    file->mappedBytes = 0;
+    return file;
+}
+
+size_t file_allocator_size(FileAllocator *file)
+{
+    struct stat status;
+    if (fstat(file->fd, &status) != 0 || (size_t)status.st_size < file->header)
+    {
+        return 0;
+    }
+    return status.st_size - file->header;
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <stddef.h>
+
+// Buffers this large are mapped directly by the system allocator and grown with mremap instead of realloc
+#define ARRAY_MAP_THRESHOLD (64 * 1024)
+
+// Where an Array gets its storage from. Every call gets the allocator itself so a
+// backend can keep its state in a struct that starts with an Allocator.
+typedef struct Allocator Allocator;
+struct Allocator {
+    const char* name;
+    // Returns NULL when the request cannot be served
+    void* (*allocate)(Allocator* self, size_t bytes);
+    // Grows or shrinks a block, keeping its first `keep` bytes. NULL on failure, the old block is then still valid
+    void* (*resize)(Allocator* self, void* data, size_t bytes, size_t newBytes, size_t keep);
+    void (*release)(Allocator* self, void* data, size_t bytes);
+    // How many bytes a request of `bytes` really gets, so callers can use the slack
+    size_t (*usable)(Allocator* self, size_t bytes);
+};
+
+// malloc/realloc for small blocks, mmap/mremap from ARRAY_MAP_THRESHOLD on
+Allocator* allocator_system(void);
+
+// Bump allocator over a fixed buffer. Release only gives back the most recent
+// block, everything else is freed at once by arena_reset.
+typedef struct ArenaAllocator ArenaAllocator;
+struct ArenaAllocator {
+    Allocator base;
+    char* memory;
+    size_t size;
+    size_t used;
+    char* last; // Most recent block, the only one that can grow in place
+};
+
+void arena_init(ArenaAllocator* arena, void* memory, size_t size);
+void arena_reset(ArenaAllocator* arena);
+
+// Equal sized blocks from a fixed buffer, kept on a free list. Requests larger
+// than a block fail, so an Array on a pool cannot grow past blockSize bytes.
+typedef struct PoolAllocator PoolAllocator;
+struct PoolAllocator {
+    Allocator base;
+    void* freeList;
+    size_t blockSize;
+    size_t freeBlocks;
+};
+
+void pool_init(PoolAllocator* pool, void* memory, size_t blockSize, size_t blocks);
+
+// Power of two blocks from 16 bytes up to ARRAY_MAP_THRESHOLD, with a free list per
+// size. A list that runs empty gets a new block carved from the buffer, and freed
+// blocks are only reused for the same size. Larger requests go to the system allocator.
+#define ALLOCATOR_SIZE_CLASSES 13
+
+typedef struct SizeClassAllocator SizeClassAllocator;
+struct SizeClassAllocator {
+    Allocator base;
+    ArenaAllocator arena;
+    void* freeLists[ALLOCATOR_SIZE_CLASSES];
+};
+
+void sizeclass_init(SizeClassAllocator* sizeClass, void* memory, size_t size);
+
+// Realtime allocator flags
+#define ALLOCATOR_PREFAULT 0x1  // Commit every page when a block is allocated or grown, not on first access
+#define ALLOCATOR_LOCK 0x2      // mlock blocks so they are never paged out
+#define ALLOCATOR_HUGEPAGES 0x4 // 2 MB aligned blocks advised for transparent hugepages
+#define ALLOCATOR_HUGETLB 0x8   // Explicit hugepages from vm.nr_hugepages, allocation fails without them
+#define ALLOCATOR_INTERLEAVE 0x10 // Spread the pages round robin over all NUMA nodes
+#define ALLOCATOR_BIND 0x20       // Put the pages on NUMA node `node`
+
+// Every block is its own mapping, set up according to flags so that page faults
+// happen in array_new/array_reserve rather than on the first access afterwards
+typedef struct RealtimeAllocator RealtimeAllocator;
+struct RealtimeAllocator {
+    Allocator base;
+    unsigned flags;
+    int node;           // For ALLOCATOR_BIND, 0 after realtime_init
+    long lockFailures;  // mlock calls refused, usually by RLIMIT_MEMLOCK
+    long placeFailures; // NUMA placements refused, see allocator_place
+};
+
+void realtime_init(RealtimeAllocator* realtime, unsigned flags);
+
+// NUMA placement with the mbind system call, no libnuma needed. Pages placed
+// before their first write land where asked, pages already there are moved.
+// One more than the highest node with memory, 1 on machines without NUMA
+int allocator_numaNodes(void);
+// policy is ALLOCATOR_INTERLEAVE or ALLOCATOR_BIND. Returns 0 when done, or -1 when
+// the kernel has no NUMA support or there is no such node: the memory then stays
+// where the kernel would put it anyway, which on a single node is the same thing.
+int allocator_place(void* data, size_t bytes, unsigned policy, int node);
+
+// A single block that is a file, mapped shared so every write lands in it. The
+// first `header` bytes of the file are kept for the owner, the block starts after
+// them. Allocating maps what is in the file (growing it if needed), so existing
+// contents are kept. Release unmaps, closes the file and frees the allocator.
+typedef struct FileAllocator FileAllocator;
+struct FileAllocator {
+    Allocator base;
+    int fd;
+    int writable;
+    size_t header;
+    char* mapping; // Whole file, header included
+    size_t mappedBytes;
+};
+
+// NULL if the file cannot be opened. Missing files are created unless read-only
+FileAllocator* file_allocator_open(const char* path, int writable, size_t header);
+// Bytes in the file after the header
+size_t file_allocator_size(FileAllocator* file);
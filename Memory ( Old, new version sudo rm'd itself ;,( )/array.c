@@ -1,23 +1,158 @@
-﻿#include <malloc.h>
-#include <stdio.h>
+﻿#include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "array.h"
 
+// Storage
+// All storage goes through the array's allocator. The system allocator hands out
+// whole pages for large buffers, so round the capacity up to use them.
+static long _array_roundCapacity(Allocator *allocator, long capacity)
+{
+    return allocator->usable(allocator, sizeof(long) * capacity) / sizeof(long);
+}
+
 // Construction / Destruction
 Array array_new(long capacity)
+{
+    return array_newWith(capacity, allocator_system());
+}
+
+// The allocator must outlive the array, every growth and the final destroy go through it
+Array array_newWith(long capacity, Allocator *allocator)
 {
     assert(capacity > 0);
-    return (Array){malloc(sizeof(long) * capacity), 0, 0, capacity};
+    capacity = _array_roundCapacity(allocator, capacity);
+    long *data = allocator->allocate(allocator, sizeof(long) * capacity);
+    assert(data != NULL);
+    return (Array){.data = data, .front = 0, .back = 0, .capacity = capacity,
+                   .growth = ARRAY_GROW_DOUBLE, .growthStep = ARRAY_DEFAULT_STEP, .flags = 0,
+                   .allocator = allocator};
+}
+
+// In ring mode front stays inside [0, capacity) and back = front + length may run
+// past the end, positions from capacity on wrap around to the start of the buffer
+Array array_newRing(long capacity)
+{
+    Array a = array_new(capacity);
+    a.flags |= ARRAY_RING;
+    return a;
 }
 
 void array_destroy(Array a)
 {
-    free(a.data);
+    if (a.refs != NULL)
+    {
+        // Snapshots may still read the buffer, the last array to go releases it
+        if (atomic_fetch_sub(a.refs, 1) > 1)
+        {
+            return;
+        }
+        free(a.refs);
+    }
+    if (a.flags & ARRAY_MAPPED)
+    {
+        array_sync(a);
+    }
+    a.allocator->release(a.allocator, a.data, sizeof(long) * a.capacity);
+}
+
+// File backed
+// The first page of the file holds this header, the elements follow from the
+// second page on. Everything past back up to the end of the file is capacity.
+#define ARRAY_FILE_MAGIC "ARRY"
+
+struct _ArrayFileHeader
+{
+    char magic[4];
+    unsigned flags;
+    long front;
+    long back;
+};
+
+// Like matrix_new, data is NULL if the file could not be opened or is not an array
+Array array_openMapped(const char *path, int mode)
+{
+    Array a = {0};
+    FileAllocator *file = file_allocator_open(path, !(mode & ARRAY_OPEN_READONLY), sysconf(_SC_PAGESIZE));
+    if (file == NULL)
+    {
+        return a;
+    }
+
+    long existing = file_allocator_size(file) / sizeof(long);
+    long capacity = _array_roundCapacity(&file->base, existing > 0 ? existing : 1);
+    if (!file->writable && existing == 0)
+    {
+        file->base.release(&file->base, NULL, 0);
+        return a;
+    }
+    long *data = file->base.allocate(&file->base, sizeof(long) * capacity);
+    if (data == NULL)
+    {
+        file->base.release(&file->base, NULL, 0);
+        return a;
+    }
+
+    // A file that was just created is all zeros
+    struct _ArrayFileHeader *header = (struct _ArrayFileHeader *)file->mapping;
+    static const char empty[4] = {0};
+    if (file->writable && memcmp(header->magic, empty, 4) == 0)
+    {
+        memcpy(header->magic, ARRAY_FILE_MAGIC, 4);
+    }
+    // A ring keeps front inside the buffer and at most capacity elements past it, any
+    // other array keeps all of [front, back) inside the buffer
+    int ring = header->flags & ARRAY_RING;
+    if (memcmp(header->magic, ARRAY_FILE_MAGIC, 4) != 0 || header->front < 0 || header->back < header->front ||
+        (ring ? header->front >= capacity || header->back - header->front > capacity : header->back > capacity))
+    {
+        file->base.release(&file->base, data, sizeof(long) * capacity);
+        return a;
+    }
+
+    a = (Array){.data = data, .front = header->front, .back = header->back, .capacity = capacity,
+                .growth = ARRAY_GROW_DOUBLE, .growthStep = ARRAY_DEFAULT_STEP,
+                .flags = (header->flags & ARRAY_RING) | ARRAY_MAPPED, .allocator = &file->base};
+    array_advise(a, mode);
+    return a;
+}
+
+// Store front and back in the file and wait for everything to be written out
+void array_sync(Array a)
+{
+    assert(a.flags & ARRAY_MAPPED);
+    FileAllocator *file = (FileAllocator *)a.allocator;
+    if (!file->writable)
+    {
+        return;
+    }
+    struct _ArrayFileHeader *header = (struct _ArrayFileHeader *)file->mapping;
+    header->flags = a.flags & ARRAY_RING;
+    header->front = a.front;
+    header->back = a.back;
+    msync(file->mapping, file->mappedBytes, MS_SYNC);
+}
+
+// Tell the kernel how the elements will be read, so it can read ahead or not. The
+// header gets the same advice: a mapping split in two could no longer grow with mremap.
+void array_advise(Array a, int mode)
+{
+    assert(a.flags & ARRAY_MAPPED);
+    FileAllocator *file = (FileAllocator *)a.allocator;
+    int advice = mode & ARRAY_OPEN_SEQUENTIAL ? MADV_SEQUENTIAL : mode & ARRAY_OPEN_RANDOM ? MADV_RANDOM : MADV_NORMAL;
+    madvise(file->mapping, file->mappedBytes, advice);
 }
 
 // Primitives
+static long _array_slot(Array a, long position)
+{
+    return position < a.capacity ? position : position - a.capacity;
+}
+
 long array_empty(Array a)
 {
     return a.back <= a.front;
@@ -30,12 +165,17 @@ long array_front(Array a)
 
 long array_back(Array a)
 {
-    return a.data[a.back - 1];
+    return a.data[_array_slot(a, a.back - 1)];
 }
 
 void array_popFront(Array *a)
 {
     a->front++;
+    if ((a->flags & ARRAY_RING) && a->front == a->capacity)
+    {
+        a->front = 0;
+        a->back -= a->capacity;
+    }
 }
 
 void array_popBack(Array *a)
@@ -43,9 +183,44 @@ void array_popBack(Array *a)
     a->back--;
 }
 
+// A cursor for walking a, sharing its buffer: only valid until a is next written to.
+// Use array_snapshot for a copy that stays valid.
 Array array_save(Array a)
 {
-    return (Array){a.data, a.front, a.back, a.capacity};
+    return a;
+}
+
+// A copy of a that keeps its elements while a is written to, in O(1). The two share
+// the buffer until one of them writes, which then copies it first. Destroy the
+// snapshot like any other array, in any order and from any thread.
+Array array_snapshot(Array *a)
+{
+    if (a->flags & ARRAY_MAPPED)
+    {
+        // The file belongs to a, the snapshot gets its elements in memory
+        long length = array_length(*a);
+        Array s = array_new(length > 0 ? length : 1);
+        s.growth = a->growth;
+        s.growthStep = a->growthStep;
+        s.flags |= a->flags & ARRAY_RING;
+        array_appendArray(&s, *a);
+        return s;
+    }
+
+    if (a->refs == NULL)
+    {
+        a->refs = malloc(sizeof(atomic_long));
+        assert(a->refs != NULL);
+        atomic_init(a->refs, 1);
+    }
+    atomic_fetch_add(a->refs, 1);
+    return *a;
+}
+
+long array_get(Array a, long index)
+{
+    assert(index >= 0 && index < array_length(a));
+    return a.data[_array_slot(a, a.front + index)];
 }
 
 // Iteration
@@ -82,6 +257,246 @@ void array_print(Array a)
     printf("}\n");
 }
 
+// Bulk operations
+// The elements are one contiguous run, or two when a ring has wrapped. Each run is
+// processed ARRAY_LANES elements at a time with GCC vector extensions, which become
+// SSE/AVX on x86 and NEON on the Raspberry Pi, and a scalar loop finishes the rest.
+#if defined(__GNUC__)
+#if defined(__AVX2__)
+#define ARRAY_LANES (32 / sizeof(long))
+#else
+#define ARRAY_LANES (16 / sizeof(long))
+#endif
+typedef long ArrayVector __attribute__((vector_size(ARRAY_LANES * sizeof(long))));
+
+static inline ArrayVector _array_load(const long *p)
+{
+    ArrayVector v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void _array_store(long *p, ArrayVector v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+static inline ArrayVector _array_splat(long value)
+{
+    ArrayVector v = {0};
+    return v + value;
+}
+#endif
+
+// Returns the number of runs (0, 1 or 2)
+static int _array_runs(Array a, long **runs, long *lengths)
+{
+    if (array_empty(a))
+    {
+        return 0;
+    }
+    runs[0] = a.data + a.front;
+    if (a.back <= a.capacity)
+    {
+        lengths[0] = a.back - a.front;
+        return 1;
+    }
+    lengths[0] = a.capacity - a.front;
+    runs[1] = a.data;
+    lengths[1] = a.back - a.capacity;
+    return 2;
+}
+
+// Copy on write
+static int _array_shared(Array a)
+{
+    return a.refs != NULL && atomic_load(a.refs) > 1;
+}
+
+// Called before every write to the buffer. While a snapshot shares it, the elements
+// are copied to a buffer of a's own first, sized for capacity elements so that a
+// growth which triggers the copy needs no second one.
+static void _array_own(Array *a, long capacity)
+{
+    if (!_array_shared(*a))
+    {
+        return;
+    }
+
+    Allocator *allocator = a->allocator;
+    capacity = _array_roundCapacity(allocator, capacity);
+    long *new_data = allocator->allocate(allocator, sizeof(long) * capacity);
+    assert(new_data != NULL);
+
+    long *runs[2], lengths[2];
+    long length = 0;
+    for (int r = 0, count = _array_runs(*a, runs, lengths); r < count; r++)
+    {
+        memcpy(new_data + length, runs[r], sizeof(long) * lengths[r]);
+        length += lengths[r];
+    }
+
+    // Drop the reference, the snapshots may all have gone since the check
+    array_destroy(*a);
+    a->data = new_data;
+    a->front = 0;
+    a->back = length;
+    a->capacity = capacity;
+    a->refs = NULL;
+}
+
+static long _array_sumRun(const long *p, long n)
+{
+    long i = 0;
+    long sum = 0;
+#if defined(__GNUC__)
+    ArrayVector acc = _array_splat(0);
+    for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+    {
+        acc += _array_load(p + i);
+    }
+    for (int lane = 0; lane < ARRAY_LANES; lane++)
+    {
+        sum += acc[lane];
+    }
+#endif
+    for (; i < n; i++)
+    {
+        sum += p[i];
+    }
+    return sum;
+}
+
+long array_sum(Array a)
+{
+    long *runs[2], lengths[2];
+    long sum = 0;
+    for (int r = _array_runs(a, runs, lengths) - 1; r >= 0; r--)
+    {
+        sum += _array_sumRun(runs[r], lengths[r]);
+    }
+    return sum;
+}
+
+// Smallest element of a run, or the largest when max is set
+static long _array_extremeRun(const long *p, long n, int max, long best)
+{
+    long i = 0;
+#if defined(__GNUC__)
+    if (n >= ARRAY_LANES)
+    {
+        ArrayVector acc = _array_splat(best);
+        for (; i + ARRAY_LANES <= n; i += ARRAY_LANES)
+        {
+            ArrayVector v = _array_load(p + i);
+            ArrayVector take = max ? v > acc : v < acc;
+            acc = (v & take) | (acc & ~take);
+        }
+        for (int lane = 0; lane < ARRAY_LANES; lane++)
+        {
+            best = max ? (acc[lane] > best ? acc[lane] : best) : (acc[lane] < best ? acc[lane] : best);
+        }
+    }
+#endif
+    for (; i < n; i++)
+    {
+        best = max ? (p[i] > best ? p[i] : best) : (p[i] < best ? p[i] : best);
+    }
+    return best;
+}
+
+long array_min(Array a)
+{
+    assert(!array_empty(a));
+    long *runs[2], lengths[2];
+    long best = array_front(a);
+    for (int r = _array_runs(a, runs, lengths) - 1; r >= 0; r--)
+    {
+        best = _array_extremeRun(runs[r], lengths[r], 0, best);
+    }
+    return best;
+}
+
+long array_max(Array a)
+{
+    assert(!array_empty(a));
+    long *runs[2], lengths[2];
+    long best = array_front(a);
+    for (int r = _array_runs(a, runs, lengths) - 1; r >= 0; r--)
+    {
+        best = _array_extremeRun(runs[r], lengths[r], 1, best);
+    }
+    return best;
+}
+
+void array_addScalar(Array *a, long value)
+{
+    long *runs[2], lengths[2];
+    _array_own(a, a->capacity);
+    for (int r = _array_runs(*a, runs, lengths) - 1; r >= 0; r--)
+    {
+        long *p = runs[r];
+        long i = 0;
+#if defined(__GNUC__)
+        ArrayVector add = _array_splat(value);
+        for (; i + ARRAY_LANES <= lengths[r]; i += ARRAY_LANES)
+        {
+            _array_store(p + i, _array_load(p + i) + add);
+        }
+#endif
+        for (; i < lengths[r]; i++)
+        {
+            p[i] += value;
+        }
+    }
+}
+
+void array_fill(Array *a, long value)
+{
+    long *runs[2], lengths[2];
+    _array_own(a, a->capacity);
+    for (int r = _array_runs(*a, runs, lengths) - 1; r >= 0; r--)
+    {
+        long *p = runs[r];
+        long i = 0;
+        if (value == 0)
+        {
+            memset(p, 0, sizeof(long) * lengths[r]);
+            continue;
+        }
+#if defined(__GNUC__)
+        ArrayVector fill = _array_splat(value);
+        for (; i + ARRAY_LANES <= lengths[r]; i += ARRAY_LANES)
+        {
+            _array_store(p + i, fill);
+        }
+#endif
+        for (; i < lengths[r]; i++)
+        {
+            p[i] = value;
+        }
+    }
+}
+
+// Keep only the elements in [low, high], in order. Compaction needs a compress
+// instruction to vectorise, so this is a branchless scalar loop. Returns the number removed.
+long array_filterRange(Array *a, long low, long high)
+{
+    assert(low <= high);
+    unsigned long width = (unsigned long)high - (unsigned long)low;
+    _array_own(a, a->capacity);
+    long kept = a->front;
+    for (long i = a->front; i < a->back; i++)
+    {
+        long x = a->data[_array_slot(*a, i)];
+        a->data[_array_slot(*a, kept)] = x;
+        kept += (unsigned long)x - (unsigned long)low <= width;
+    }
+    long removed = a->back - kept;
+    a->back = kept;
+    return removed;
+}
+
 // Capacity
 long array_length(Array a)
 {
@@ -95,20 +510,215 @@ void array_reserve(Array *a, long capacity)
         return;
     }
 
+    if (_array_shared(*a))
+    {
+        // The copy a needs anyway is the growth
+        _array_own(a, capacity);
+        return;
+    }
+
+    Allocator *allocator = a->allocator;
+    capacity = _array_roundCapacity(allocator, capacity);
     long length = array_length(*a);
-    long *new_data = malloc(sizeof(long) * capacity);
-    assert(new_data != NULL);
 
-    // Move existing elements to start of new storage
-    for (long i = 0; i < length; i++)
+    if (a->flags & ARRAY_RING)
     {
-        new_data[i] = a->data[a->front + i];
+        // Elements keep their slots, only a wrapped part has to move
+        long *new_data = allocator->resize(allocator, a->data, sizeof(long) * a->capacity,
+                                           sizeof(long) * capacity, sizeof(long) * a->capacity);
+        assert(new_data != NULL);
+
+        long wrapped = a->back - a->capacity;
+        if (wrapped > 0 && wrapped <= capacity - a->capacity)
+        {
+            // Unwrap: the elements at the start of the buffer follow on after the old end
+            memcpy(new_data + a->capacity, new_data, sizeof(long) * wrapped);
+        }
+        else if (wrapped > 0)
+        {
+            // Not enough new room for that, slide the part before the wrap to the new end instead
+            long head = a->capacity - a->front;
+            memmove(new_data + capacity - head, new_data + a->front, sizeof(long) * head);
+            a->front = capacity - head;
+            a->back = a->front + length;
+        }
+
+        a->data = new_data;
+        a->capacity = capacity;
+        return;
     }
 
-    free(a->data);
-    a->data = new_data;
+    if (a->front == 0)
+    {
+        // Elements already start at the beginning, let realloc/mremap extend the block
+        long *new_data = allocator->resize(allocator, a->data, sizeof(long) * a->capacity,
+                                           sizeof(long) * capacity, sizeof(long) * length);
+        assert(new_data != NULL);
+        a->data = new_data;
+    }
+    else if (a->flags & ARRAY_MAPPED)
+    {
+        // A file is a single block, slide the elements to its start and extend it
+        memmove(a->data, a->data + a->front, sizeof(long) * length);
+        long *new_data = allocator->resize(allocator, a->data, sizeof(long) * a->capacity,
+                                           sizeof(long) * capacity, sizeof(long) * length);
+        assert(new_data != NULL);
+        a->data = new_data;
+    }
+    else
+    {
+        long *new_data = allocator->allocate(allocator, sizeof(long) * capacity);
+        assert(new_data != NULL);
+
+        // Move existing elements to start of new storage
+        memcpy(new_data, a->data + a->front, sizeof(long) * length);
+
+        allocator->release(allocator, a->data, sizeof(long) * a->capacity);
+        a->data = new_data;
+    }
+
+    a->front = 0;
+    a->back = length;
+    a->capacity = capacity;
+}
+
+void array_setGrowth(Array *a, ArrayGrowth growth, long step)
+{
+    assert(growth != ARRAY_GROW_FIXED || step > 0);
+    a->growth = growth;
+    a->growthStep = step > 0 ? step : ARRAY_DEFAULT_STEP;
+}
+
+// Round a byte count up to a size class with four steps per power of two
+// (like glibc bins and jemalloc classes), less malloc's per-chunk header
+static long _array_sizeClassBytes(long bytes)
+{
+    long header = sizeof(size_t);
+    long total = bytes + header;
+    long power = 32;
+    while (power * 2 <= total)
+    {
+        power *= 2;
+    }
+    long step = power / 4;
+    return (total + step - 1) / step * step - header;
+}
+
+long array_nextCapacity(Array a, long required)
+{
+    long capacity = a.capacity > 0 ? a.capacity : 1;
+    long next;
+
+    switch (a.growth)
+    {
+    case ARRAY_GROW_HALF:
+        next = capacity + (capacity + 1) / 2;
+        break;
+    case ARRAY_GROW_GOLDEN:
+        next = capacity + (capacity * 618 + 999) / 1000;
+        break;
+    case ARRAY_GROW_SIZE_CLASS:
+        next = _array_sizeClassBytes(sizeof(long) * (capacity + (capacity + 1) / 2)) / sizeof(long);
+        break;
+    case ARRAY_GROW_FIXED:
+        next = capacity + a.growthStep;
+        break;
+    default:
+        next = capacity * 2;
+        break;
+    }
+    return next < required ? required : next;
+}
+
+// Make room for n more elements at the back with at most one reserve or copy
+static void _array_ensure(Array *a, long n)
+{
+    long required = array_length(*a) + n;
+    if (a->flags & ARRAY_RING ? required > a->capacity : a->back + n > a->capacity)
+    {
+        array_reserve(a, array_nextCapacity(*a, required));
+    }
+    else
+    {
+        _array_own(a, a->capacity);
+    }
+}
+
+// Grow or cut to exactly length elements, new ones set to fill
+void array_resize(Array *a, long length, long fill)
+{
+    assert(length >= 0);
+    long old = array_length(*a);
+    if (length <= old)
+    {
+        a->back = a->front + length;
+        return;
+    }
+
+    _array_ensure(a, length - old);
+    // The new elements as an array of their own, with front inside the buffer like any ring
+    Array added = *a;
+    added.front = _array_slot(*a, a->back);
+    added.back = added.front + length - old;
+    a->back = a->front + length;
+    array_fill(&added, fill);
+}
+
+// Move the elements to [0, length) of the buffer, unwrapping a ring
+static void _array_reverse(long *p, long n)
+{
+    for (long i = 0, j = n - 1; i < j; i++, j--)
+    {
+        long t = p[i];
+        p[i] = p[j];
+        p[j] = t;
+    }
+}
+
+void array_linearize(Array *a)
+{
+    _array_own(a, a->capacity);
+    long length = array_length(*a);
+    if (a->back > a->capacity)
+    {
+        // A wrapped ring: close the gap so the buffer starts with the wrapped part and
+        // then the part before the wrap, and swap the two by reversing. No scratch
+        // buffer, which would bypass the array's allocator.
+        long head = a->capacity - a->front;
+        long wrapped = a->back - a->capacity;
+        memmove(a->data + wrapped, a->data + a->front, sizeof(long) * head);
+        _array_reverse(a->data, wrapped);
+        _array_reverse(a->data + wrapped, head);
+        _array_reverse(a->data, length);
+    }
+    else if (a->front > 0)
+    {
+        memmove(a->data, a->data + a->front, sizeof(long) * length);
+    }
     a->front = 0;
     a->back = length;
+}
+
+// Give back all capacity beyond the length, moving the elements to the start of the buffer
+void array_shrinkToFit(Array *a)
+{
+    long length = array_length(*a);
+    long capacity = _array_roundCapacity(a->allocator, length > 0 ? length : 1);
+    if (capacity >= a->capacity)
+    {
+        return;
+    }
+    if (_array_shared(*a))
+    {
+        _array_own(a, capacity);
+        return;
+    }
+
+    array_linearize(a);
+    long *new_data = a->allocator->resize(a->allocator, a->data, sizeof(long) * a->capacity,
+                                          sizeof(long) * capacity, sizeof(long) * length);
+    assert(new_data != NULL);
+    a->data = new_data;
     a->capacity = capacity;
 }
 
@@ -116,16 +726,45 @@ void array_reserve(Array *a, long capacity)
 void array_insertBack(Array *a, long stuff)
 {
     // Ensure capacity (Task C): grow when necessary
-    if (a->back >= a->capacity)
+    _array_ensure(a, 1);
+    a->data[_array_slot(*a, a->back)] = stuff;
+    a->back++;
+}
+
+void array_insertFront(Array *a, long stuff)
+{
+    assert(a->flags & ARRAY_RING);
+    _array_ensure(a, 1);
+    if (--a->front < 0)
     {
-        long currentLength = array_length(*a);
-        long newCapacity = a->capacity > 0 ? a->capacity * 2 : 1;
-        if (newCapacity < currentLength + 1)
-        {
-            newCapacity = currentLength + 1;
-        }
-        array_reserve(a, newCapacity);
+        a->front += a->capacity;
+        a->back += a->capacity;
+    }
+    a->data[a->front] = stuff;
+}
+
+// One reserve, then one copy, or two when a ring wraps around the end of the buffer
+void array_insertBackN(Array *a, const long *stuff, long n)
+{
+    assert(n >= 0);
+    _array_ensure(a, n);
+    long slot = _array_slot(*a, a->back);
+    long first = n < a->capacity - slot ? n : a->capacity - slot;
+    memcpy(a->data + slot, stuff, sizeof(long) * first);
+    memcpy(a->data, stuff + first, sizeof(long) * (n - first));
+    a->back += n;
+}
+
+// b must not share its buffer with a, growing a could free it. A snapshot is fine,
+// it keeps the buffer when a copies it.
+void array_appendArray(Array *a, Array b)
+{
+    long *runs[2], lengths[2];
+    int count = _array_runs(b, runs, lengths);
+    assert(b.data != a->data || _array_shared(b));
+    _array_ensure(a, array_length(b));
+    for (int r = 0; r < count; r++)
+    {
+        array_insertBackN(a, runs[r], lengths[r]);
     }
-    a->data[a->back] = stuff;
-    a->back++;
 }
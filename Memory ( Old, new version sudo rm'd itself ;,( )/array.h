@@ -1,17 +1,53 @@
 ﻿#pragma once
 
+#include <stdatomic.h>
+
+#include "allocator.h"
+
+// How much insertBack grows the capacity when it runs out
+typedef enum {
+    ARRAY_GROW_DOUBLE,     // 2x, fewest relocations
+    ARRAY_GROW_HALF,       // 1.5x, smaller spikes, freed blocks can be reused sooner
+    ARRAY_GROW_GOLDEN,     // 1.618x, the largest factor where freed blocks can add up to the next one
+    ARRAY_GROW_SIZE_CLASS, // 1.5x rounded up to the malloc size class it lands in anyway
+    ARRAY_GROW_FIXED       // growthStep elements at a time, bounded work per growth for real-time use
+} ArrayGrowth;
+
+#define ARRAY_DEFAULT_STEP 1024
+
+// Array flags
+#define ARRAY_RING 0x1 // Circular buffer: popFront space is reused and insertFront is allowed
+#define ARRAY_MAPPED 0x2 // Backed by a file from array_openMapped, array_destroy syncs it
+
+// array_openMapped modes
+#define ARRAY_OPEN_READONLY 0x1
+#define ARRAY_OPEN_SEQUENTIAL 0x2 // madvise hints for how the elements will be accessed
+#define ARRAY_OPEN_RANDOM 0x4
+
 typedef struct Array Array;
 struct Array {
     long* data;
     long front;
     long back;   
     long capacity; 
+    ArrayGrowth growth;
+    long growthStep;
+    unsigned flags;
+    Allocator* allocator;
+    atomic_long* refs; // Arrays sharing data through array_snapshot, NULL until the first snapshot
 };
 
 // Construction / Destruction
 Array array_new(long capacity);
+Array array_newWith(long capacity, Allocator* allocator);
+Array array_newRing(long capacity);
 void array_destroy(Array a);
 
+// File backed
+Array array_openMapped(const char* path, int mode);
+void array_sync(Array a);
+void array_advise(Array a, int mode);
+
 // Primitives
 long array_empty(Array a);
 long array_front(Array a);
@@ -19,15 +55,60 @@ long array_back(Array a);
 void array_popFront(Array* a);
 void array_popBack(Array* a);
 Array array_save(Array a);
+Array array_snapshot(Array* a);
+long array_get(Array a, long index);
 
 // Iteration
 void array_foreach(Array a, void fn(long));
 void array_foreachReverse(Array a, void fn(long));
 void array_print(Array a);
 
+// Inline iteration without a callback, the body sees each element as x:
+//     ARRAY_FOREACH(x, a) { sum += x; }
+#define ARRAY_FOREACH(x, a) \
+    for (long _array_i = (a).front, x; \
+         _array_i < (a).back && ((x = (a).data[_array_i < (a).capacity ? _array_i : _array_i - (a).capacity]), 1); \
+         _array_i++)
+
+#define ARRAY_FOREACH_REVERSE(x, a) \
+    for (long _array_i = (a).back - 1, x; \
+         _array_i >= (a).front && ((x = (a).data[_array_i < (a).capacity ? _array_i : _array_i - (a).capacity]), 1); \
+         _array_i--)
+
+// Bulk operations over [front, back), vectorised where the compiler supports it
+long array_sum(Array a);
+long array_min(Array a);
+long array_max(Array a);
+void array_addScalar(Array* a, long value);
+void array_fill(Array* a, long value);
+long array_filterRange(Array* a, long low, long high);
+
+// Ordering, in array_sort.c. The searches expect a sorted array.
+void array_sort(Array* a);
+long array_lowerBound(Array a, long value);
+long array_binarySearch(Array a, long value);
+
+// Parallel, in array_parallel.c. [front, back) is cut into chunks of about grain
+// elements (ARRAY_PARALLEL_GRAIN when 0) that run on a pool of one thread per core,
+// started on first use. fn and map are called concurrently and in no set order.
+// combine must be associative with identity as its neutral element, the results
+// of the chunks are combined in order.
+#define ARRAY_PARALLEL_GRAIN 4096
+void array_parallelForeach(Array a, void fn(long), long grain);
+long array_parallelReduce(Array a, long identity, long map(long), long combine(long, long), long grain);
+void array_parallelResize(Array* a, long length, long fill, long grain);
+
 // Capacity
 long array_length(Array a);
 void array_reserve(Array* a, long capacity);
+void array_setGrowth(Array* a, ArrayGrowth growth, long step);
+long array_nextCapacity(Array a, long required);
+void array_resize(Array* a, long length, long fill);
+void array_shrinkToFit(Array* a);
+void array_linearize(Array* a);
 
 // Modifiers
 void array_insertBack(Array* a, long stuff);
+void array_insertFront(Array* a, long stuff);
+void array_insertBackN(Array* a, const long* stuff, long n);
+void array_appendArray(Array* a, Array b);
@@ -0,0 +1,344 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "array.h"
+
+#define ARRAY_POOL_THREADS 64
+// Chunk boundaries fall on cache lines, so no two threads write the same line
+#define ARRAY_LINE (64 / (long)sizeof(long))
+
+// Work stealing
+// Every worker owns a range of chunk numbers, packed as first << 32 | last into one
+// atomic word on its own cache line. The owner takes chunks off the front, and a
+// worker that runs out steals the back half of another worker's range. Both are a
+// single compare and swap, so nobody ever waits for a lock while there is work left.
+struct _ArrayRange
+{
+    _Alignas(64) _Atomic uint64_t chunks;
+};
+
+struct _ArrayJob
+{
+    const long *data;
+    long front, back, capacity;
+    // Chunk c is positions [start + c * chunk, start + (c + 1) * chunk) cut to [front, back)
+    long start, chunk, chunks;
+    void (*fn)(long);
+    long (*map)(long);
+    long (*combine)(long, long);
+    long identity;
+    long *results; // One per chunk, for reduce
+    long *target;  // Set for resize, the chunks are written with identity
+    int threads;
+    struct _ArrayRange ranges[ARRAY_POOL_THREADS];
+};
+
+static uint64_t _array_pack(long first, long last)
+{
+    return (uint64_t)first << 32 | (uint64_t)last;
+}
+
+static long _array_take(struct _ArrayRange *range)
+{
+    uint64_t v = atomic_load(&range->chunks);
+    for (;;)
+    {
+        long first = v >> 32, last = v & 0xffffffff;
+        if (first >= last)
+        {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak(&range->chunks, &v, _array_pack(first + 1, last)))
+        {
+            return first;
+        }
+    }
+}
+
+// Move the back half of some other worker's chunks to the thief's own, now empty, range
+static int _array_steal(struct _ArrayJob *job, int thief)
+{
+    for (int k = 1; k < job->threads; k++)
+    {
+        struct _ArrayRange *victim = &job->ranges[(thief + k) % job->threads];
+        uint64_t v = atomic_load(&victim->chunks);
+        for (;;)
+        {
+            long first = v >> 32, last = v & 0xffffffff;
+            if (first >= last)
+            {
+                break;
+            }
+            long middle = first + (last - first) / 2;
+            if (atomic_compare_exchange_weak(&victim->chunks, &v, _array_pack(first, middle)))
+            {
+                atomic_store(&job->ranges[thief].chunks, _array_pack(middle, last));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void _array_runChunk(struct _ArrayJob *job, long c)
+{
+    long first = job->start + c * job->chunk;
+    long last = first + job->chunk;
+    first = first < job->front ? job->front : first;
+    last = last > job->back ? job->back : last;
+
+    long acc = job->identity;
+    while (first < last)
+    {
+        // A chunk of a ring can run past the end of the buffer, do it as two runs
+        long slot = first < job->capacity ? first : first - job->capacity;
+        long end = first < job->capacity && last > job->capacity ? job->capacity : last;
+        const long *p = job->data + slot;
+        long n = end - first;
+        if (job->target != NULL)
+        {
+            for (long i = 0; i < n; i++)
+            {
+                job->target[slot + i] = job->identity;
+            }
+        }
+        else if (job->fn != NULL)
+        {
+            for (long i = 0; i < n; i++)
+            {
+                job->fn(p[i]);
+            }
+        }
+        else
+        {
+            for (long i = 0; i < n; i++)
+            {
+                acc = job->combine(acc, job->map != NULL ? job->map(p[i]) : p[i]);
+            }
+        }
+        first = end;
+    }
+    if (job->results != NULL)
+    {
+        job->results[c] = acc;
+    }
+}
+
+static void _array_work(struct _ArrayJob *job, int id)
+{
+    for (;;)
+    {
+        long c = _array_take(&job->ranges[id]);
+        if (c < 0)
+        {
+            if (!_array_steal(job, id))
+            {
+                return;
+            }
+            continue;
+        }
+        _array_runChunk(job, c);
+    }
+}
+
+// Pool
+// One thread per core the process may run on when it is first used, less the
+// calling thread, which takes part in every job. The threads sleep between jobs.
+struct _ArrayPool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    int threads;
+    int running;
+    unsigned long generation;
+    struct _ArrayJob *job;
+};
+
+static struct _ArrayPool _array_pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
+static pthread_once_t _array_poolOnce = PTHREAD_ONCE_INIT;
+// One job at a time when several threads use the pool
+static pthread_mutex_t _array_submit = PTHREAD_MUTEX_INITIALIZER;
+// Set in pool threads and in a caller running a job, a nested call runs on its own
+static __thread int _array_inPool;
+
+static void *_array_poolThread(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    unsigned long seen = 0;
+    _array_inPool = 1;
+
+    pthread_mutex_lock(&_array_pool.lock);
+    for (;;)
+    {
+        while (_array_pool.generation == seen)
+        {
+            pthread_cond_wait(&_array_pool.wake, &_array_pool.lock);
+        }
+        seen = _array_pool.generation;
+        struct _ArrayJob *job = _array_pool.job;
+        pthread_mutex_unlock(&_array_pool.lock);
+
+        _array_work(job, id);
+
+        pthread_mutex_lock(&_array_pool.lock);
+        if (--_array_pool.running == 0)
+        {
+            pthread_cond_signal(&_array_pool.done);
+        }
+    }
+    return NULL;
+}
+
+static void _array_poolStart(void)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        cores = CPU_COUNT(&set);
+    }
+#endif
+    _array_pool.threads = cores < 1 ? 1 : cores > ARRAY_POOL_THREADS ? ARRAY_POOL_THREADS : cores;
+    for (int t = 1; t < _array_pool.threads; t++)
+    {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, _array_poolThread, (void *)(intptr_t)t) != 0)
+        {
+            // Run with the threads there are
+            _array_pool.threads = t;
+            break;
+        }
+        pthread_detach(thread);
+    }
+}
+
+static void _array_parallelRun(struct _ArrayJob *job)
+{
+    pthread_once(&_array_poolOnce, _array_poolStart);
+    int threads = _array_pool.threads;
+    if (_array_inPool || threads == 1 || job->chunks == 1)
+    {
+        for (long c = 0; c < job->chunks; c++)
+        {
+            _array_runChunk(job, c);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&_array_submit);
+    job->threads = threads;
+    for (int t = 0; t < threads; t++)
+    {
+        atomic_init(&job->ranges[t].chunks, _array_pack(job->chunks * t / threads, job->chunks * (t + 1) / threads));
+    }
+
+    pthread_mutex_lock(&_array_pool.lock);
+    _array_pool.job = job;
+    _array_pool.running = threads - 1;
+    _array_pool.generation++;
+    pthread_cond_broadcast(&_array_pool.wake);
+    pthread_mutex_unlock(&_array_pool.lock);
+
+    _array_inPool = 1;
+    _array_work(job, 0);
+    _array_inPool = 0;
+
+    pthread_mutex_lock(&_array_pool.lock);
+    while (_array_pool.running > 0)
+    {
+        pthread_cond_wait(&_array_pool.done, &_array_pool.lock);
+    }
+    pthread_mutex_unlock(&_array_pool.lock);
+    pthread_mutex_unlock(&_array_submit);
+}
+
+// Split [front, back) into chunks of at least grain elements that start on cache lines
+static struct _ArrayJob *_array_parallelJob(Array *a, long grain)
+{
+    struct _ArrayJob *job = malloc(sizeof(struct _ArrayJob));
+    assert(job != NULL && grain >= 0);
+    grain = grain > 0 ? grain : ARRAY_PARALLEL_GRAIN;
+
+    job->data = a->data;
+    job->front = a->front;
+    job->back = a->back;
+    job->capacity = a->capacity;
+    job->start = a->front - (long)((uintptr_t)(job->data + a->front) / sizeof(long) % ARRAY_LINE);
+    job->chunk = (grain + ARRAY_LINE - 1) / ARRAY_LINE * ARRAY_LINE;
+    // Chunk numbers have to fit the 32 bit halves of a range
+    long span = a->back - job->start;
+    while (span / job->chunk >= 0x7fffffff)
+    {
+        job->chunk *= 2;
+    }
+    job->chunks = span > 0 ? (span + job->chunk - 1) / job->chunk : 0;
+    job->fn = NULL;
+    job->map = NULL;
+    job->combine = NULL;
+    job->identity = 0;
+    job->results = NULL;
+    job->target = NULL;
+    return job;
+}
+
+// Parallel
+void array_parallelForeach(Array a, void fn(long), long grain)
+{
+    struct _ArrayJob *job = _array_parallelJob(&a, grain);
+    job->fn = fn;
+    _array_parallelRun(job);
+    free(job);
+}
+
+// array_resize with the new elements written by the pool's threads. Each thread
+// touches the pages of its chunks first, so on a NUMA machine they are put on its
+// node: the same threads then find them local in array_parallelForeach/Reduce.
+void array_parallelResize(Array *a, long length, long fill, long grain)
+{
+    long old = array_length(*a);
+    if (length <= old)
+    {
+        array_resize(a, length, fill);
+        return;
+    }
+
+    // One contiguous buffer of a's own, then pages past the old elements are still untouched
+    array_linearize(a);
+    array_reserve(a, length);
+    Array added = *a;
+    added.front = old;
+    added.back = length;
+    struct _ArrayJob *job = _array_parallelJob(&added, grain);
+    job->target = added.data;
+    job->identity = fill;
+    a->back = length;
+    _array_parallelRun(job);
+    free(job);
+}
+
+long array_parallelReduce(Array a, long identity, long map(long), long combine(long, long), long grain)
+{
+    struct _ArrayJob *job = _array_parallelJob(&a, grain);
+    job->map = map;
+    job->combine = combine;
+    job->identity = identity;
+    job->results = malloc(sizeof(long) * (job->chunks > 0 ? job->chunks : 1));
+    assert(job->results != NULL);
+    _array_parallelRun(job);
+
+    long acc = identity;
+    for (long c = 0; c < job->chunks; c++)
+    {
+        acc = combine(acc, job->results[c]);
+    }
+    free(job->results);
+    free(job);
+    return acc;
+}
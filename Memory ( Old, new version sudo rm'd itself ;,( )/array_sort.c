@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "array.h"
+
+// Below this many elements array_sort uses introsort, radix passes cost more than they save
+#define ARRAY_SORT_SMALL 4096
+// Every radix thread gets at least this many elements
+#define ARRAY_SORT_GRAIN (256 * 1024)
+#define ARRAY_SORT_THREADS 64
+
+#define ARRAY_RADIX_BITS 8
+#define ARRAY_RADIX (1 << ARRAY_RADIX_BITS)
+// Flipping the sign bit makes signed order the same as unsigned order
+#define ARRAY_SIGN (1UL << (sizeof(long) * 8 - 1))
+
+// Introsort
+// Quicksort with median of three, heapsort when the recursion gets too deep, and
+// insertion sort for the short ranges left at the bottom
+static void _array_insertionSort(long *p, long n)
+{
+    for (long i = 1; i < n; i++)
+    {
+        long x = p[i];
+        long j = i;
+        for (; j > 0 && p[j - 1] > x; j--)
+        {
+            p[j] = p[j - 1];
+        }
+        p[j] = x;
+    }
+}
+
+static void _array_siftDown(long *p, long root, long n)
+{
+    long x = p[root];
+    for (long child = 2 * root + 1; child < n; child = 2 * root + 1)
+    {
+        if (child + 1 < n && p[child + 1] > p[child])
+        {
+            child++;
+        }
+        if (p[child] <= x)
+        {
+            break;
+        }
+        p[root] = p[child];
+        root = child;
+    }
+    p[root] = x;
+}
+
+static void _array_heapSort(long *p, long n)
+{
+    for (long i = n / 2 - 1; i >= 0; i--)
+    {
+        _array_siftDown(p, i, n);
+    }
+    for (long end = n - 1; end > 0; end--)
+    {
+        long top = p[0];
+        p[0] = p[end];
+        p[end] = top;
+        _array_siftDown(p, 0, end);
+    }
+}
+
+static void _array_introSort(long *p, long n, int depth)
+{
+    while (n > 16)
+    {
+        if (depth-- == 0)
+        {
+            _array_heapSort(p, n);
+            return;
+        }
+
+        long a = p[0], b = p[n / 2], c = p[n - 1];
+        long pivot = a < b ? (b < c ? b : (a < c ? c : a)) : (a < c ? a : (b < c ? c : b));
+        long i = 0, j = n - 1;
+        while (i <= j)
+        {
+            while (p[i] < pivot)
+            {
+                i++;
+            }
+            while (p[j] > pivot)
+            {
+                j--;
+            }
+            if (i <= j)
+            {
+                long t = p[i];
+                p[i++] = p[j];
+                p[j--] = t;
+            }
+        }
+
+        // Recurse into the smaller side, loop on the larger
+        if (j + 1 < n - i)
+        {
+            _array_introSort(p, j + 1, depth);
+            p += i;
+            n -= i;
+        }
+        else
+        {
+            _array_introSort(p + i, n - i, depth);
+            n = j + 1;
+        }
+    }
+    _array_insertionSort(p, n);
+}
+
+// Radix sort
+// LSD, one byte per pass, stable. Every thread counts the digits of its own slice,
+// the counts are turned into one output offset per thread and digit, and each
+// thread scatters its slice there. Passes where every key has the same digit are skipped.
+struct _ArraySort
+{
+    long *source;
+    long *target;
+    long n;
+    int threads;
+    int skip;
+    long counts[ARRAY_SORT_THREADS][ARRAY_RADIX];
+    pthread_barrier_t barrier;
+    // Workers wait here until it is known how many of them were started
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    int started;
+};
+
+struct _ArraySortWorker
+{
+    struct _ArraySort *sort;
+    int id;
+};
+
+static long _array_digit(long x, int shift)
+{
+    return (((unsigned long)x ^ ARRAY_SIGN) >> shift) & (ARRAY_RADIX - 1);
+}
+
+static void *_array_radixWorker(void *arg)
+{
+    struct _ArraySortWorker *worker = arg;
+    struct _ArraySort *sort = worker->sort;
+    int id = worker->id;
+    pthread_mutex_lock(&sort->lock);
+    while (!sort->started)
+    {
+        pthread_cond_wait(&sort->start, &sort->lock);
+    }
+    pthread_mutex_unlock(&sort->lock);
+    long first = sort->n * id / sort->threads;
+    long last = sort->n * (id + 1) / sort->threads;
+
+    for (int shift = 0; shift < (int)sizeof(long) * 8; shift += ARRAY_RADIX_BITS)
+    {
+        long *count = sort->counts[id];
+        memset(count, 0, sizeof(sort->counts[id]));
+        for (long i = first; i < last; i++)
+        {
+            count[_array_digit(sort->source[i], shift)]++;
+        }
+        pthread_barrier_wait(&sort->barrier);
+
+        if (id == 0)
+        {
+            // Offsets in digit-major, thread-minor order keep the sort stable
+            long offset = 0;
+            sort->skip = 0;
+            for (int d = 0; d < ARRAY_RADIX; d++)
+            {
+                long total = 0;
+                for (int t = 0; t < sort->threads; t++)
+                {
+                    long c = sort->counts[t][d];
+                    sort->counts[t][d] = offset;
+                    offset += c;
+                    total += c;
+                }
+                sort->skip |= total == sort->n;
+            }
+        }
+        pthread_barrier_wait(&sort->barrier);
+
+        if (!sort->skip)
+        {
+            for (long i = first; i < last; i++)
+            {
+                long x = sort->source[i];
+                sort->target[count[_array_digit(x, shift)]++] = x;
+            }
+        }
+        pthread_barrier_wait(&sort->barrier);
+
+        if (id == 0 && !sort->skip)
+        {
+            long *swap = sort->source;
+            sort->source = sort->target;
+            sort->target = swap;
+        }
+        pthread_barrier_wait(&sort->barrier);
+    }
+    return NULL;
+}
+
+// Cores this process may run on, so taskset and cpusets limit the sort too
+static long _array_cores(void)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        return CPU_COUNT(&set);
+    }
+#endif
+    return sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+static void _array_radixSort(long *p, long n)
+{
+    Allocator *system = allocator_system();
+    long *buffer = system->allocate(system, sizeof(long) * n);
+    // The counts are too large for the stack
+    struct _ArraySort *sort = malloc(sizeof(struct _ArraySort));
+    assert(buffer != NULL && sort != NULL);
+
+    long cores = _array_cores();
+    long threads = n / ARRAY_SORT_GRAIN;
+    threads = threads < 1 ? 1 : threads > cores ? cores : threads;
+    threads = threads > ARRAY_SORT_THREADS ? ARRAY_SORT_THREADS : threads;
+
+    sort->source = p;
+    sort->target = buffer;
+    sort->n = n;
+    sort->started = 0;
+    pthread_mutex_init(&sort->lock, NULL);
+    pthread_cond_init(&sort->start, NULL);
+
+    // If a thread can not be created the sort runs on the ones that were, down to
+    // the calling thread alone. They only split the keys once the count is known.
+    pthread_t workers[ARRAY_SORT_THREADS];
+    struct _ArraySortWorker args[ARRAY_SORT_THREADS];
+    args[0] = (struct _ArraySortWorker){sort, 0};
+    for (int t = 1; t < threads; t++)
+    {
+        args[t] = (struct _ArraySortWorker){sort, t};
+        if (pthread_create(&workers[t], NULL, _array_radixWorker, &args[t]) != 0)
+        {
+            threads = t;
+            break;
+        }
+    }
+    sort->threads = threads;
+    pthread_barrier_init(&sort->barrier, NULL, threads);
+    pthread_mutex_lock(&sort->lock);
+    sort->started = 1;
+    pthread_cond_broadcast(&sort->start);
+    pthread_mutex_unlock(&sort->lock);
+    _array_radixWorker(&args[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        pthread_join(workers[t], NULL);
+    }
+
+    if (sort->source != p)
+    {
+        memcpy(p, sort->source, sizeof(long) * n);
+    }
+    pthread_barrier_destroy(&sort->barrier);
+    pthread_cond_destroy(&sort->start);
+    pthread_mutex_destroy(&sort->lock);
+    free(sort);
+    system->release(system, buffer, sizeof(long) * n);
+}
+
+void array_sort(Array *a)
+{
+    array_linearize(a);
+    long *p = a->data;
+    long n = array_length(*a);
+    if (n < ARRAY_SORT_SMALL)
+    {
+        int depth = 0;
+        for (long m = n; m > 1; m >>= 1)
+        {
+            depth += 2;
+        }
+        _array_introSort(p, n, depth);
+    }
+    else
+    {
+        _array_radixSort(p, n);
+    }
+}
+
+// Search
+// Branchless: the loop always runs log2(n) times and the compare becomes a
+// conditional move, so there are no mispredictions to pay for. Both possible
+// next probes are prefetched, which hides some of the cache misses on large arrays.
+static long _array_lowerBoundRun(const long *data, long n, long value)
+{
+    const long *base = data;
+    while (n > 1)
+    {
+        long half = n / 2;
+        __builtin_prefetch(base + (n - half) / 2);
+        __builtin_prefetch(base + half + (n - half) / 2);
+        base = base[half] < value ? base + half : base;
+        n -= half;
+    }
+    return base - data + (*base < value);
+}
+
+long array_lowerBound(Array a, long value)
+{
+    long n = array_length(a);
+    if (n == 0)
+    {
+        return 0;
+    }
+    const long *data = a.data;
+    if (a.back <= a.capacity)
+    {
+        return _array_lowerBoundRun(data + a.front, n, value);
+    }
+
+    // A sorted ring that has wrapped, pick the run first
+    long head = a.capacity - a.front;
+    if (data[a.capacity - 1] >= value)
+    {
+        return _array_lowerBoundRun(data + a.front, head, value);
+    }
+    return head + _array_lowerBoundRun(data, n - head, value);
+}
+
+// Index of value, or -1 when it is not there
+long array_binarySearch(Array a, long value)
+{
+    long i = array_lowerBound(a, value);
+    return i < array_length(a) && array_get(a, i) == value ? i : -1;
+}
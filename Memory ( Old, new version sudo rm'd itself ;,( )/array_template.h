@@ -0,0 +1,190 @@
+#pragma once
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Type-specialised dynamic arrays. ARRAY_DEFINE(name, T) generates a struct `name`
+// holding elements of type T and the same API as array.h with `name` in place of
+// `array`, all static inline so every element size is a compile-time constant:
+//
+//     ARRAY_DEFINE(ByteArray, uint8_t)
+//     ByteArray b = ByteArray_new(16);
+//     ByteArray_insertBack(&b, 42);
+//     ByteArray_destroy(b);
+//
+// Growth is 2x through realloc. Ring mode works as in array.h: front stays inside
+// [0, capacity), back may run past the end, and the positions past it wrap around.
+
+#define ARRAY_TEMPLATE_RING 0x1
+
+#define ARRAY_DEFINE(name, T)                                                              \
+    typedef struct name name;                                                              \
+    struct name {                                                                          \
+        T* data;                                                                           \
+        long front;                                                                        \
+        long back;                                                                         \
+        long capacity;                                                                     \
+        unsigned flags;                                                                    \
+    };                                                                                     \
+                                                                                           \
+    /* Construction / Destruction */                                                       \
+    static inline name name##_new(long capacity)                                           \
+    {                                                                                      \
+        assert(capacity > 0);                                                              \
+        T* data = (T*)malloc(sizeof(T) * capacity);                                        \
+        assert(data != NULL);                                                              \
+        return (name){data, 0, 0, capacity, 0};                                            \
+    }                                                                                      \
+                                                                                           \
+    static inline name name##_newRing(long capacity)                                       \
+    {                                                                                      \
+        name a = name##_new(capacity);                                                     \
+        a.flags |= ARRAY_TEMPLATE_RING;                                                    \
+        return a;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_destroy(name a)                                              \
+    {                                                                                      \
+        free(a.data);                                                                      \
+    }                                                                                      \
+                                                                                           \
+    /* Primitives */                                                                       \
+    static inline long name##_slot(name a, long position)                                  \
+    {                                                                                      \
+        return position < a.capacity ? position : position - a.capacity;                   \
+    }                                                                                      \
+                                                                                           \
+    static inline long name##_empty(name a)                                                \
+    {                                                                                      \
+        return a.back <= a.front;                                                          \
+    }                                                                                      \
+                                                                                           \
+    static inline T name##_front(name a)                                                   \
+    {                                                                                      \
+        return a.data[a.front];                                                            \
+    }                                                                                      \
+                                                                                           \
+    static inline T name##_back(name a)                                                    \
+    {                                                                                      \
+        return a.data[name##_slot(a, a.back - 1)];                                         \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_popFront(name* a)                                            \
+    {                                                                                      \
+        a->front++;                                                                        \
+        if ((a->flags & ARRAY_TEMPLATE_RING) && a->front == a->capacity)                   \
+        {                                                                                  \
+            a->front = 0;                                                                  \
+            a->back -= a->capacity;                                                        \
+        }                                                                                  \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_popBack(name* a)                                             \
+    {                                                                                      \
+        a->back--;                                                                         \
+    }                                                                                      \
+                                                                                           \
+    static inline name name##_save(name a)                                                 \
+    {                                                                                      \
+        return a;                                                                          \
+    }                                                                                      \
+                                                                                           \
+    static inline T* name##_at(name a, long index)                                         \
+    {                                                                                      \
+        assert(index >= 0 && index < a.back - a.front);                                    \
+        return &a.data[name##_slot(a, a.front + index)];                                   \
+    }                                                                                      \
+                                                                                           \
+    static inline T name##_get(name a, long index)                                         \
+    {                                                                                      \
+        return *name##_at(a, index);                                                       \
+    }                                                                                      \
+                                                                                           \
+    /* Iteration */                                                                        \
+    static inline void name##_foreach(name a, void fn(T))                                  \
+    {                                                                                      \
+        for (name b = name##_save(a); !name##_empty(b); name##_popFront(&b))               \
+        {                                                                                  \
+            fn(name##_front(b));                                                           \
+        }                                                                                  \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_foreachReverse(name a, void fn(T))                           \
+    {                                                                                      \
+        for (name b = name##_save(a); !name##_empty(b); name##_popBack(&b))                \
+        {                                                                                  \
+            fn(name##_back(b));                                                            \
+        }                                                                                  \
+    }                                                                                      \
+                                                                                           \
+    /* Capacity */                                                                         \
+    static inline long name##_length(name a)                                               \
+    {                                                                                      \
+        return a.back - a.front;                                                           \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_reserve(name* a, long capacity)                              \
+    {                                                                                      \
+        if (capacity <= a->capacity)                                                       \
+        {                                                                                  \
+            return;                                                                        \
+        }                                                                                  \
+        long length = name##_length(*a);                                                   \
+        long wrapped = a->back - a->capacity;                                              \
+        if (!(a->flags & ARRAY_TEMPLATE_RING) && a->front > 0)                             \
+        {                                                                                  \
+            /* Slide to the start first so realloc only has to keep the live part */       \
+            memmove(a->data, a->data + a->front, sizeof(T) * length);                      \
+            a->front = 0;                                                                  \
+            a->back = length;                                                              \
+        }                                                                                  \
+        T* data = (T*)realloc(a->data, sizeof(T) * capacity);                              \
+        assert(data != NULL);                                                              \
+        if (wrapped > 0 && wrapped <= capacity - a->capacity)                              \
+        {                                                                                  \
+            memcpy(data + a->capacity, data, sizeof(T) * wrapped);                         \
+        }                                                                                  \
+        else if (wrapped > 0)                                                              \
+        {                                                                                  \
+            long head = a->capacity - a->front;                                            \
+            memmove(data + capacity - head, data + a->front, sizeof(T) * head);            \
+            a->front = capacity - head;                                                    \
+            a->back = a->front + length;                                                   \
+        }                                                                                  \
+        a->data = data;                                                                    \
+        a->capacity = capacity;                                                            \
+    }                                                                                      \
+                                                                                           \
+    /* Modifiers */                                                                        \
+    static inline void name##_grow(name* a)                                                \
+    {                                                                                      \
+        long length = name##_length(*a);                                                   \
+        name##_reserve(a, a->capacity * 2 > length + 1 ? a->capacity * 2 : length + 1);    \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_insertBack(name* a, T stuff)                                 \
+    {                                                                                      \
+        if (a->flags & ARRAY_TEMPLATE_RING ? name##_length(*a) == a->capacity              \
+                                           : a->back >= a->capacity)                       \
+        {                                                                                  \
+            name##_grow(a);                                                                \
+        }                                                                                  \
+        a->data[name##_slot(*a, a->back)] = stuff;                                         \
+        a->back++;                                                                         \
+    }                                                                                      \
+                                                                                           \
+    static inline void name##_insertFront(name* a, T stuff)                                \
+    {                                                                                      \
+        assert(a->flags & ARRAY_TEMPLATE_RING);                                            \
+        if (name##_length(*a) == a->capacity)                                              \
+        {                                                                                  \
+            name##_grow(a);                                                                \
+        }                                                                                  \
+        if (--a->front < 0)                                                                \
+        {                                                                                  \
+            a->front += a->capacity;                                                       \
+            a->back += a->capacity;                                                        \
+        }                                                                                  \
+        a->data[a->front] = stuff;                                                         \
+    }
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "array.h"
+
+// Allocation latency of each Allocator backend on a fragmented heap. The heap is
+// first filled with blocks of random size and every other one is freed, then a
+// random mix of allocations and frees is timed call by call. The arena ignores
+// frees and is reset whenever it runs full, which is not counted.
+// Build with make bench_allocator
+//
+// Usage: ./bench_allocator [operations]   (default 1e6)
+
+#define MAX_BLOCK 4096
+#define LIVE_BLOCKS 65536
+#define ARENA_BYTES (64L * 1024 * 1024)
+
+struct Block
+{
+    void *data;
+    size_t bytes;
+};
+
+static unsigned long long rngState = 4147;
+
+static unsigned long bench_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (unsigned long)((rngState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+// Fill every slot, then free every other one so the free space is scattered
+static void fragment(Allocator *allocator, struct Block *blocks)
+{
+    for (int i = 0; i < LIVE_BLOCKS; i++)
+    {
+        blocks[i].bytes = 16 + bench_random() % (MAX_BLOCK - 16);
+        blocks[i].data = allocator->allocate(allocator, blocks[i].bytes);
+    }
+    for (int i = 0; i < LIVE_BLOCKS; i += 2)
+    {
+        if (blocks[i].data != NULL)
+        {
+            allocator->release(allocator, blocks[i].data, blocks[i].bytes);
+            blocks[i].data = NULL;
+        }
+    }
+}
+
+static void measure(Allocator *allocator, ArenaAllocator *arena, long operations, long *latencies)
+{
+    struct Block *blocks = calloc(LIVE_BLOCKS, sizeof(struct Block));
+    long count = 0, failed = 0;
+
+    rngState = 4147;
+    fragment(allocator, blocks);
+
+    for (long op = 0; op < operations; op++)
+    {
+        struct Block *block = &blocks[bench_random() % LIVE_BLOCKS];
+        if (block->data != NULL)
+        {
+            allocator->release(allocator, block->data, block->bytes);
+            block->data = NULL;
+            continue;
+        }
+
+        block->bytes = 16 + bench_random() % (MAX_BLOCK - 16);
+        long start = now_ns();
+        block->data = allocator->allocate(allocator, block->bytes);
+        latencies[count++] = now_ns() - start;
+
+        if (block->data == NULL && arena != NULL)
+        {
+            // Bulk free, the old blocks are all gone at once
+            arena_reset(arena);
+            for (int i = 0; i < LIVE_BLOCKS; i++)
+            {
+                blocks[i].data = NULL;
+            }
+        }
+        else if (block->data == NULL)
+        {
+            failed++;
+        }
+        else
+        {
+            // Touch it, as the caller would
+            memset(block->data, 1, block->bytes);
+        }
+    }
+
+    for (int i = 0; i < LIVE_BLOCKS && arena == NULL; i++)
+    {
+        if (blocks[i].data != NULL)
+        {
+            allocator->release(allocator, blocks[i].data, blocks[i].bytes);
+        }
+    }
+    free(blocks);
+
+    if (count == 0)
+    {
+        printf("%-8s %10ld  no allocations timed, %ld failed\n", allocator->name, count, failed);
+        return;
+    }
+    qsort(latencies, count, sizeof(long), compare_long);
+    printf("%-8s %10ld %8ld %8ld %8ld %8ld %10ld %8ld\n", allocator->name, count, latencies[count / 2],
+           latencies[count * 99 / 100], latencies[count * 999 / 1000], latencies[count * 99999 / 100000],
+           latencies[count - 1], failed);
+}
+
+int main(int argc, char *argv[])
+{
+    long operations = argc > 1 ? (long)atof(argv[1]) : 1000000L;
+    long *latencies = malloc(sizeof(long) * operations);
+
+    // The fixed buffers are touched up front so page faults are not counted for them
+    char *arenaMemory = malloc(ARENA_BYTES);
+    char *poolMemory = aligned_alloc(MAX_BLOCK, (size_t)LIVE_BLOCKS * MAX_BLOCK);
+    memset(arenaMemory, 0, ARENA_BYTES);
+    memset(poolMemory, 0, (size_t)LIVE_BLOCKS * MAX_BLOCK);
+
+    ArenaAllocator arena;
+    PoolAllocator pool;
+    arena_init(&arena, arenaMemory, ARENA_BYTES);
+    pool_init(&pool, poolMemory, MAX_BLOCK, LIVE_BLOCKS);
+
+    printf("%-8s %10s %8s %8s %8s %8s %10s %8s\n", "backend", "allocs", "p50 ns", "p99", "p99.9", "p99.999", "max ns", "failed");
+    measure(allocator_system(), NULL, operations, latencies);
+    measure(&arena.base, &arena, operations, latencies);
+    measure(&pool.base, NULL, operations, latencies);
+
+    free(arenaMemory);
+    free(poolMemory);
+    free(latencies);
+    return 0;
+}
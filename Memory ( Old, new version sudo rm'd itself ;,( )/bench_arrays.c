@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "array.h"
+
+// Array and the dynamic_arr from "sanntidssystemer oving 2.txt" on each allocator
+// backend: glibc malloc, the system allocator (malloc, mmap from 64 KB), a bump
+// arena, size classes and a mapping per block. The workload is rounds of requests
+// on a set of arrays, with a skewed pick so a few of them grow long: mostly appends,
+// a quarter pops and a few arrays destroyed and started over. Every array is destroyed
+// at the end of a round, and the arena is reset then.
+//
+// Every allocate and resize call is timed. Fragmentation is the resident memory
+// of the process over the bytes the arrays hold, in the round where it peaks. Each
+// case runs in a child process so it starts with a fresh heap.
+// Build with make bench_arrays
+//
+// Usage: ./bench_arrays [operations] [arrays]   (default 1e7, 1024)
+
+#define ROUNDS 20
+#define MAX_LATENCIES 4000000
+#define BUFFER_BYTES (1024L * 1024 * 1024)
+
+// dynamic_arr as in the exercise, with malloc and free through an Allocator
+typedef struct {
+    size_t size;
+    size_t cap;
+    int* data;
+    Allocator* allocator;
+} dynamic_arr;
+
+static int dynamic_reserve(dynamic_arr *a, size_t new_cap)
+{
+    if (new_cap <= a->cap)
+    {
+        return 0;
+    }
+    int *new_data = a->allocator->allocate(a->allocator, new_cap * sizeof(int));
+    if (!new_data)
+    {
+        return -1;
+    }
+    for (size_t i = 0; i < a->size; ++i)
+    {
+        new_data[i] = a->data[i];
+    }
+    if (a->data != NULL)
+    {
+        a->allocator->release(a->allocator, a->data, a->cap * sizeof(int));
+    }
+    a->data = new_data;
+    a->cap = new_cap;
+    return 0;
+}
+
+static int dynamic_insert_back(dynamic_arr *arr, int val)
+{
+    if (arr->size == arr->cap && (arr->size == 0 ? dynamic_reserve(arr, 8) : dynamic_reserve(arr, arr->size * 2)))
+    {
+        return -1;
+    }
+    arr->data[arr->size++] = val;
+    return 0;
+}
+
+// Allocators
+// glibc malloc on its own, without the system allocator's mappings
+static void *malloc_allocate(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return malloc(bytes);
+}
+
+static void *malloc_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    (void)self;
+    (void)bytes;
+    (void)keep;
+    return realloc(data, newBytes);
+}
+
+static void malloc_release(Allocator *self, void *data, size_t bytes)
+{
+    (void)self;
+    (void)bytes;
+    free(data);
+}
+
+static size_t malloc_usable(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return bytes;
+}
+
+// Forwards to the backend under test and times the calls that allocate
+typedef struct {
+    Allocator base;
+    Allocator *inner;
+} TimedAllocator;
+
+static long *latencies;
+static long latencyCount;
+
+static long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static void record(long start)
+{
+    if (latencyCount < MAX_LATENCIES)
+    {
+        latencies[latencyCount++] = now_ns() - start;
+    }
+}
+
+static void *timed_allocate(Allocator *self, size_t bytes)
+{
+    Allocator *inner = ((TimedAllocator *)self)->inner;
+    long start = now_ns();
+    void *data = inner->allocate(inner, bytes);
+    record(start);
+    return data;
+}
+
+static void *timed_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    Allocator *inner = ((TimedAllocator *)self)->inner;
+    long start = now_ns();
+    void *newData = inner->resize(inner, data, bytes, newBytes, keep);
+    record(start);
+    return newData;
+}
+
+static void timed_release(Allocator *self, void *data, size_t bytes)
+{
+    Allocator *inner = ((TimedAllocator *)self)->inner;
+    inner->release(inner, data, bytes);
+}
+
+static size_t timed_usable(Allocator *self, size_t bytes)
+{
+    Allocator *inner = ((TimedAllocator *)self)->inner;
+    return inner->usable(inner, bytes);
+}
+
+// Workload
+struct Slot
+{
+    int live;
+    Array array;
+    dynamic_arr dynamic;
+};
+
+struct Result
+{
+    double seconds;
+    long operations;
+    long p50, p99, p999, max;
+    double liveMB, rssMB;
+};
+
+static unsigned long long rngState = 4147;
+
+static unsigned long bench_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (unsigned long)((rngState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static long rss_bytes(void)
+{
+    long pages = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f != NULL)
+    {
+        if (fscanf(f, "%ld %ld", &pages, &resident) != 2)
+        {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static void destroy_slot(struct Slot *s, int dynamic, Allocator *allocator)
+{
+    if (dynamic && s->dynamic.data != NULL)
+    {
+        allocator->release(allocator, s->dynamic.data, s->dynamic.cap * sizeof(int));
+    }
+    else if (!dynamic)
+    {
+        array_destroy(s->array);
+    }
+    s->live = 0;
+}
+
+static void run(int dynamic, Allocator *backend, ArenaAllocator *arena, long operations, int arrays,
+                struct Result *result)
+{
+    TimedAllocator timed = {{backend->name, timed_allocate, timed_resize, timed_release, timed_usable}, backend};
+    Allocator *allocator = &timed.base;
+    struct Slot *slots = calloc(arrays, sizeof(struct Slot));
+    latencies = malloc(sizeof(long) * MAX_LATENCIES);
+    memset(latencies, 0, sizeof(long) * MAX_LATENCIES);
+    long baseline = rss_bytes();
+
+    double seconds = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        long start = now_ns();
+        for (long op = 0; op < operations / ROUNDS; op++)
+        {
+            // Skewed towards the first arrays, which grow long
+            struct Slot *s = &slots[bench_random() % (1 + bench_random() % arrays)];
+            unsigned long what = bench_random() % 1000;
+            if (!s->live)
+            {
+                if (dynamic)
+                {
+                    s->dynamic = (dynamic_arr){0, 0, NULL, allocator};
+                }
+                else
+                {
+                    s->array = array_newWith(1, allocator);
+                }
+                s->live = 1;
+            }
+            if (what < 750)
+            {
+                if (dynamic)
+                {
+                    dynamic_insert_back(&s->dynamic, (int)op);
+                }
+                else
+                {
+                    array_insertBack(&s->array, op);
+                }
+            }
+            else if (what < 998)
+            {
+                if (dynamic && s->dynamic.size > 0)
+                {
+                    s->dynamic.size--;
+                }
+                else if (!dynamic && !array_empty(s->array))
+                {
+                    array_popBack(&s->array);
+                }
+            }
+            else
+            {
+                destroy_slot(s, dynamic, allocator);
+            }
+        }
+        seconds += (now_ns() - start) / 1e9;
+
+        // Fragmentation at the end of the round, when the arrays are at their fullest
+        long live = 0;
+        for (int i = 0; i < arrays; i++)
+        {
+            if (slots[i].live)
+            {
+                live += dynamic ? (long)(slots[i].dynamic.size * sizeof(int)) : array_length(slots[i].array) * (long)sizeof(long);
+            }
+        }
+        long rss = rss_bytes() - baseline;
+        if (rss > result->rssMB * 1e6)
+        {
+            result->liveMB = live / 1e6;
+            result->rssMB = rss / 1e6;
+        }
+
+        start = now_ns();
+        for (int i = 0; i < arrays; i++)
+        {
+            if (slots[i].live)
+            {
+                destroy_slot(&slots[i], dynamic, allocator);
+            }
+        }
+        if (arena != NULL)
+        {
+            arena_reset(arena);
+        }
+        seconds += (now_ns() - start) / 1e9;
+    }
+
+    qsort(latencies, latencyCount, sizeof(long), compare_long);
+    result->seconds = seconds;
+    result->operations = operations / ROUNDS * ROUNDS;
+    result->p50 = latencies[latencyCount / 2];
+    result->p99 = latencies[latencyCount * 99 / 100];
+    result->p999 = latencies[latencyCount * 999 / 1000];
+    result->max = latencyCount > 0 ? latencies[latencyCount - 1] : 0;
+    free(latencies);
+    free(slots);
+}
+
+// The buffers of the arena and the size classes are only touched as they are used,
+// so the resident memory shows what was really carved out of them
+static void measure(const char *backendName, int dynamic, long operations, int arrays)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return;
+    }
+    if (fork() == 0)
+    {
+        close(fds[0]);
+        struct Result result = {0};
+        void *buffer = malloc(BUFFER_BYTES);
+        ArenaAllocator arena;
+        SizeClassAllocator sizeClass;
+        RealtimeAllocator perBlock;
+        Allocator mallocOnly = {"malloc", malloc_allocate, malloc_resize, malloc_release, malloc_usable};
+        arena_init(&arena, buffer, BUFFER_BYTES);
+        sizeclass_init(&sizeClass, buffer, BUFFER_BYTES);
+        realtime_init(&perBlock, 0);
+
+        if (strcmp(backendName, "malloc") == 0)
+        {
+            run(dynamic, &mallocOnly, NULL, operations, arrays, &result);
+        }
+        else if (strcmp(backendName, "system") == 0)
+        {
+            run(dynamic, allocator_system(), NULL, operations, arrays, &result);
+        }
+        else if (strcmp(backendName, "arena") == 0)
+        {
+            run(dynamic, &arena.base, &arena, operations, arrays, &result);
+        }
+        else if (strcmp(backendName, "sizeclass") == 0)
+        {
+            run(dynamic, &sizeClass.base, NULL, operations, arrays, &result);
+        }
+        else
+        {
+            run(dynamic, &perBlock.base, NULL, operations, arrays, &result);
+        }
+        if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    struct Result result;
+    int ok = read(fds[0], &result, sizeof(result)) == sizeof(result);
+    close(fds[0]);
+    wait(NULL);
+
+    if (!ok)
+    {
+        printf("%-8s %-10s  failed\n", dynamic ? "dynamic" : "Array", backendName);
+        return;
+    }
+    printf("%-8s %-10s %8.1f %8ld %8ld %8ld %10ld %9.1f %9.1f %8.2f\n", dynamic ? "dynamic" : "Array", backendName,
+           result.operations / result.seconds / 1e6, result.p50, result.p99, result.p999, result.max, result.liveMB,
+           result.rssMB, result.liveMB > 0 ? result.rssMB / result.liveMB : 0);
+}
+
+int main(int argc, char *argv[])
+{
+    long operations = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    int arrays = argc > 2 ? atoi(argv[2]) : 1024;
+    const char *backends[] = {"malloc", "system", "arena", "sizeclass", "mmap"};
+
+    printf("%ld operations on %d arrays in %d rounds, Array holds longs and dynamic_arr ints\n", operations, arrays, ROUNDS);
+    printf("%-8s %-10s %8s %8s %8s %8s %10s %9s %9s %8s\n", "array", "allocator", "Mops/s", "p50 ns", "p99", "p99.9",
+           "max ns", "live MB", "RSS MB", "RSS/live");
+    for (int dynamic = 0; dynamic <= 1; dynamic++)
+    {
+        for (int b = 0; b < 5; b++)
+        {
+            measure(backends[b], dynamic, operations, arrays);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "array.h"
+
+// Bulk loading an Array: one array_insertBack per element against
+// array_insertBackN (all at once and in 4096 element chunks, as when streaming),
+// array_appendArray, and array_resize with a fill value against a fill loop.
+// The source buffer is written before timing so its page faults are not counted.
+// Build with make bench_bulk
+//
+// Usage: ./bench_bulk [elements]   (default 1e8, needs about 2.5 GB)
+
+#define CHUNK 4096
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double seconds, Array a, long n, long expected)
+{
+    printf("%-22s %10.4f %8.2f %8.2f%s\n", name, seconds, seconds * 1e9 / n,
+           sizeof(long) * n / seconds / 1e9, array_length(a) == n && array_sum(a) == expected ? "" : "  WRONG RESULT");
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 100000000L;
+    long *source = malloc(sizeof(long) * n);
+    for (long i = 0; i < n; i++)
+    {
+        source[i] = i;
+    }
+    long sum = n * (n - 1) / 2;
+
+    printf("%ld elements\n", n);
+    printf("%-22s %10s %8s %8s\n", "method", "seconds", "ns/elem", "GB/s");
+
+    Array a = array_new(1);
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(&a, source[i]);
+    }
+    report("insertBack loop", now() - start, a, n, sum);
+
+    Array b = array_new(1);
+    start = now();
+    array_insertBackN(&b, source, n);
+    report("insertBackN", now() - start, b, n, sum);
+    array_destroy(b);
+
+    b = array_new(1);
+    start = now();
+    for (long i = 0; i < n; i += CHUNK)
+    {
+        array_insertBackN(&b, source + i, n - i < CHUNK ? n - i : CHUNK);
+    }
+    report("insertBackN chunks", now() - start, b, n, sum);
+    array_destroy(b);
+
+    b = array_new(1);
+    start = now();
+    array_appendArray(&b, a);
+    report("appendArray", now() - start, b, n, sum);
+    array_destroy(b);
+    array_destroy(a);
+
+    a = array_new(1);
+    start = now();
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(&a, 1);
+    }
+    report("fill loop", now() - start, a, n, n);
+    array_destroy(a);
+
+    a = array_new(1);
+    start = now();
+    array_resize(&a, n, 1);
+    report("resize", now() - start, a, n, n);
+
+    array_resize(&a, n / 10, 0);
+    start = now();
+    array_shrinkToFit(&a);
+    printf("%-22s %10.4f  capacity %ld\n", "shrinkToFit to 10%", now() - start, a.capacity);
+    array_destroy(a);
+
+    free(source);
+    return 0;
+}
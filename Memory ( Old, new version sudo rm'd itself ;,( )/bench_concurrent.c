@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "array.h"
+#include "carray.h"
+
+// Several producer threads appending to one array: ConcurrentArray against an
+// Array with a mutex around every array_insertBack, from 1 thread up to the
+// given maximum. Every thread appends the same share of the elements, and the
+// result is checked by summing it afterwards.
+// Build with make bench_concurrent
+//
+// Usage: ./bench_concurrent [elements] [max_threads]   (default 1e7, 2 x cores)
+
+struct Producer
+{
+    pthread_t thread;
+    long first;
+    long count;
+};
+
+static ConcurrentArray concurrent;
+static Array locked;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void *produce_concurrent(void *arg)
+{
+    struct Producer *p = arg;
+    for (long i = p->first; i < p->first + p->count; i++)
+    {
+        carray_insertBack(&concurrent, i);
+    }
+    return NULL;
+}
+
+static void *produce_locked(void *arg)
+{
+    struct Producer *p = arg;
+    for (long i = p->first; i < p->first + p->count; i++)
+    {
+        pthread_mutex_lock(&lock);
+        array_insertBack(&locked, i);
+        pthread_mutex_unlock(&lock);
+    }
+    return NULL;
+}
+
+static long checkSum;
+static void sum_cb(long x) { checkSum += x; }
+
+static double run(void *(*produce)(void *), int threads, long n)
+{
+    struct Producer *producers = malloc(sizeof(struct Producer) * threads);
+    double start = now();
+    for (int t = 0; t < threads; t++)
+    {
+        producers[t].first = n / threads * t;
+        producers[t].count = t == threads - 1 ? n - producers[t].first : n / threads;
+        pthread_create(&producers[t].thread, NULL, produce, &producers[t]);
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(producers[t].thread, NULL);
+    }
+    double seconds = now() - start;
+    free(producers);
+    return seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    int maxThreads = argc > 2 ? atoi(argv[2]) : 2 * (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long expected = n * (n - 1) / 2;
+
+    printf("%ld elements, %ld cores\n", n, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %14s %14s %8s\n", "threads", "concurrent M/s", "mutex M/s", "speedup");
+    for (int threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        carray_init(&concurrent);
+        double concurrentSeconds = run(produce_concurrent, threads, n);
+        checkSum = 0;
+        carray_foreach(&concurrent, sum_cb);
+        int concurrentOk = carray_length(&concurrent) == n && checkSum == expected;
+        carray_destroy(&concurrent);
+
+        locked = array_new(1);
+        double lockedSeconds = run(produce_locked, threads, n);
+        int lockedOk = array_length(locked) == n && array_sum(locked) == expected;
+        array_destroy(locked);
+
+        printf("%8d %14.1f %14.1f %8.2f%s\n", threads, n / concurrentSeconds / 1e6, n / lockedSeconds / 1e6,
+               lockedSeconds / concurrentSeconds, concurrentOk && lockedOk ? "" : "  WRONG RESULT");
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "array.h"
+#include "matrix.h"
+
+// First-access jitter with and without the realtime memory mode. A buffer is
+// allocated, then the first write to every page is timed on its own. With lazy
+// commit each of those writes takes a page fault; prefaulted, locked or hugepage
+// backed buffers move that cost into the allocation. Covers Array through the
+// system and realtime allocators, and the matrix with and without prefault.
+// mlock beyond RLIMIT_MEMLOCK (ulimit -l) is refused and reported.
+// Build with make bench_firsttouch
+//
+// Usage: ./bench_firsttouch [megabytes]   (default 64)
+
+static long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, long allocNs, long *latencies, long count, const char *note)
+{
+    qsort(latencies, count, sizeof(long), compare_long);
+    printf("%-22s %10.3f %8ld %8ld %8ld %10ld  %s\n", name, allocNs / 1e6, latencies[count / 2],
+           latencies[count * 99 / 100], latencies[count * 999 / 1000], latencies[count - 1], note);
+}
+
+// Time the first write to each page of data
+static long touch_pages(long *data, long elements, long *latencies)
+{
+    long pageLongs = sysconf(_SC_PAGESIZE) / sizeof(long);
+    long count = 0;
+    for (long i = 0; i < elements; i += pageLongs)
+    {
+        long start = now_ns();
+        data[i] = i;
+        latencies[count++] = now_ns() - start;
+    }
+    return count;
+}
+
+static void measure_array(const char *name, unsigned flags, long elements, long *latencies)
+{
+    RealtimeAllocator realtime;
+    Allocator *allocator = allocator_system();
+    if (flags != 0)
+    {
+        realtime_init(&realtime, flags);
+        allocator = &realtime.base;
+    }
+
+    long start = now_ns();
+    Array a = array_newWith(elements, allocator);
+    long allocNs = now_ns() - start;
+
+    long count = touch_pages(a.data, elements, latencies);
+    char note[64] = "";
+    if (flags & ALLOCATOR_LOCK)
+    {
+        snprintf(note, sizeof(note), "%s", realtime.lockFailures ? "mlock refused" : "locked");
+    }
+    report(name, allocNs, latencies, count, note);
+    array_destroy(a);
+}
+
+static void measure_matrix(const char *name, unsigned flags, long elements, long *latencies)
+{
+    long x_dim = 1000;
+    long start = now_ns();
+    Matrix m = matrix_new(x_dim, elements / x_dim, flags);
+    long allocNs = now_ns() - start;
+    if (m.data == NULL)
+    {
+        printf("%-22s failed\n", name);
+        return;
+    }
+
+    long count = touch_pages(m.data, x_dim * m.y_dim, latencies);
+    const char *note = "";
+    if (flags & MATRIX_LOCK)
+    {
+        note = m.flags & MATRIX_LOCK ? "locked" : "mlock refused";
+    }
+    report(name, allocNs, latencies, count, note);
+    matrix_destroy(m);
+}
+
+// Explicit hugepages fail outright when none are reserved, and array_new asserts
+static long reserved_hugepages(void)
+{
+    long pages = 0;
+    FILE *file = fopen("/proc/sys/vm/nr_hugepages", "r");
+    if (file != NULL)
+    {
+        if (fscanf(file, "%ld", &pages) != 1)
+        {
+            pages = 0;
+        }
+        fclose(file);
+    }
+    return pages;
+}
+
+int main(int argc, char *argv[])
+{
+    long megabytes = argc > 1 ? atol(argv[1]) : 64;
+    long elements = megabytes * 1024 * 1024 / sizeof(long);
+    long *latencies = malloc(sizeof(long) * (elements / (sysconf(_SC_PAGESIZE) / sizeof(long)) + 1));
+
+    printf("%ld MB, first write to every page\n", megabytes);
+    printf("%-22s %10s %8s %8s %8s %10s\n", "buffer", "alloc ms", "p50 ns", "p99", "p99.9", "max ns");
+    measure_array("array system", 0, elements, latencies);
+    measure_array("array prefault", ALLOCATOR_PREFAULT, elements, latencies);
+    measure_array("array prefault+lock", ALLOCATOR_PREFAULT | ALLOCATOR_LOCK, elements, latencies);
+    measure_array("array thp", ALLOCATOR_HUGEPAGES, elements, latencies);
+    measure_array("array prefault+thp", ALLOCATOR_PREFAULT | ALLOCATOR_HUGEPAGES, elements, latencies);
+    if (reserved_hugepages() > 0)
+    {
+        measure_array("array hugetlb", ALLOCATOR_PREFAULT | ALLOCATOR_HUGETLB, elements, latencies);
+    }
+    else
+    {
+        printf("%-22s skipped, no hugepages reserved (vm.nr_hugepages)\n", "array hugetlb");
+    }
+    measure_matrix("matrix", 0, elements, latencies);
+    measure_matrix("matrix prefault+lock", MATRIX_PREFAULT | MATRIX_LOCK, elements, latencies);
+    measure_matrix("matrix prefault+huge", MATRIX_PREFAULT | MATRIX_HUGEPAGES, elements, latencies);
+
+    free(latencies);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "array.h"
+
+// Growth cost and peak RSS of appending n elements, comparing the old
+// malloc + copy + free growth with the realloc/mremap path in array_reserve.
+// Every measurement runs in its own child process so ru_maxrss is its own peak.
+// Build with make bench_growth
+//
+// Usage: ./bench_growth [max_elements]   (default 1e8, 1e9 needs about 8 GB)
+
+struct Result
+{
+    double seconds;
+    long moves; // Times the elements ended up at a new address
+};
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// The original growth: allocate, copy element by element, free
+static struct Result append_copying(long n)
+{
+    struct Result result = {0, 0};
+    long capacity = 1, length = 0;
+    long *data = malloc(sizeof(long) * capacity);
+
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        if (length == capacity)
+        {
+            long *new_data = malloc(sizeof(long) * capacity * 2);
+            for (long j = 0; j < length; j++)
+            {
+                new_data[j] = data[j];
+            }
+            free(data);
+            data = new_data;
+            capacity *= 2;
+            result.moves++;
+        }
+        data[length++] = i;
+    }
+    result.seconds = now() - start;
+
+    free(data);
+    return result;
+}
+
+static struct Result append_array(long n)
+{
+    struct Result result = {0, 0};
+    Array a = array_new(1);
+
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        long *before = a.data;
+        array_insertBack(&a, i);
+        if (a.data != before)
+        {
+            result.moves++;
+        }
+    }
+    result.seconds = now() - start;
+
+    array_destroy(a);
+    return result;
+}
+
+static void measure(const char *name, struct Result (*append)(long), long n)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        struct Result result = append(n);
+        if (write(fds[1], &result, sizeof(result)) != sizeof(result))
+        {
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    struct Result result;
+    struct rusage usage;
+    int status;
+    close(fds[1]);
+    long got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    wait4(pid, &status, 0, &usage);
+
+    if (got != sizeof(result) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        printf("%-8s %12ld  failed (out of memory?)\n", name, n);
+        return;
+    }
+
+    printf("%-8s %12ld %12.4f %10.2f %8ld %12.1f\n", name, n, result.seconds,
+           result.seconds * 1e9 / n, result.moves, usage.ru_maxrss / 1024.0);
+}
+
+int main(int argc, char *argv[])
+{
+    long max = argc > 1 ? (long)atof(argv[1]) : 100000000L;
+
+    printf("%-8s %12s %12s %10s %8s %12s\n", "growth", "elements", "seconds", "ns/elem", "moves", "peak RSS MB");
+    for (long n = 1000; n <= max; n *= 10)
+    {
+        measure("copy", append_copying, n);
+        measure("array", append_array, n);
+    }
+    return 0;
+}
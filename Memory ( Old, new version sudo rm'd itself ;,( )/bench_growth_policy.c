@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "array.h"
+
+// Compares the growth policies of Array under append-heavy workloads:
+// reallocations, bytes actually copied (realloc that had to move, not mremap),
+// how often a grown buffer landed in memory an earlier buffer had given back,
+// and peak RSS. Each case runs in a child process of its own.
+// Build with make bench_growth_policy
+//
+// Usage: ./bench_growth_policy [elements]   (default 1e7)
+
+#define ARRAYS_IN_PARALLEL 16
+#define MAX_FREED 4096
+
+static const char *growthString[] = {"2x", "1.5x", "golden", "sizeclass", "fixed"};
+static const char *workloadString[] = {"append", "interleaved", "parallel"};
+
+struct Stats
+{
+    double seconds;
+    long reallocations;
+    long bytesCopied;
+    long reused;
+};
+
+// Buffers given back so far, to see whether a later buffer is placed inside one
+struct Freed
+{
+    char *start;
+    long bytes;
+};
+
+static struct Freed freed[MAX_FREED];
+static int freedCount;
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void tracked_insert(Array *a, long value, struct Stats *stats)
+{
+    long *before = a->data;
+    long capacity = a->capacity;
+    long length = array_length(*a);
+
+    array_insertBack(a, value);
+    if (a->capacity == capacity)
+    {
+        return;
+    }
+
+    stats->reallocations++;
+    if (a->data == before)
+    {
+        return;
+    }
+
+    // Mapped buffers are moved by mremap without touching the elements
+    if (capacity * (long)sizeof(long) < ARRAY_MAP_THRESHOLD)
+    {
+        stats->bytesCopied += length * sizeof(long);
+    }
+
+    for (int i = 0; i < freedCount; i++)
+    {
+        if ((char *)a->data >= freed[i].start && (char *)a->data < freed[i].start + freed[i].bytes)
+        {
+            stats->reused++;
+            break;
+        }
+    }
+    if (freedCount < MAX_FREED)
+    {
+        freed[freedCount].start = (char *)before;
+        freed[freedCount].bytes = capacity * sizeof(long);
+        freedCount++;
+    }
+}
+
+static struct Stats run_workload(int workload, ArrayGrowth growth, long n)
+{
+    struct Stats stats = {0, 0, 0, 0};
+    Array arrays[ARRAYS_IN_PARALLEL];
+    int count = workload == 2 ? ARRAYS_IN_PARALLEL : 1;
+    void **pinned = NULL;
+    long pinnedCount = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        arrays[i] = array_new(1);
+        array_setGrowth(&arrays[i], growth, ARRAY_DEFAULT_STEP);
+    }
+    if (workload == 1)
+    {
+        pinned = malloc(sizeof(void *) * (n / 1000 + 1));
+    }
+
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        tracked_insert(&arrays[i % count], i, &stats);
+
+        // Small long-lived allocations in between, like the rest of a program would make
+        if (workload == 1 && i % 1000 == 0)
+        {
+            pinned[pinnedCount++] = malloc(64 + i % 4096);
+        }
+    }
+    stats.seconds = now() - start;
+
+    for (int i = 0; i < count; i++)
+    {
+        array_destroy(arrays[i]);
+    }
+    for (long i = 0; i < pinnedCount; i++)
+    {
+        free(pinned[i]);
+    }
+    free(pinned);
+    return stats;
+}
+
+static void measure(int workload, ArrayGrowth growth, long n)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        struct Stats stats = run_workload(workload, growth, n);
+        _exit(write(fds[1], &stats, sizeof(stats)) == sizeof(stats) ? 0 : 1);
+    }
+
+    struct Stats stats;
+    struct rusage usage;
+    int status;
+    close(fds[1]);
+    long got = read(fds[0], &stats, sizeof(stats));
+    close(fds[0]);
+    wait4(pid, &status, 0, &usage);
+
+    if (got != sizeof(stats))
+    {
+        printf("%-12s %-10s failed\n", workloadString[workload], growthString[growth]);
+        return;
+    }
+
+    printf("%-12s %-10s %10.4f %8ld %14ld %7ld %12.1f\n", workloadString[workload], growthString[growth],
+           stats.seconds, stats.reallocations, stats.bytesCopied, stats.reused, usage.ru_maxrss / 1024.0);
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+
+    printf("%ld elements per workload\n", n);
+    printf("%-12s %-10s %10s %8s %14s %7s %12s\n", "workload", "growth", "seconds", "reallocs", "bytes copied", "reused", "peak RSS MB");
+    for (int workload = 0; workload < 3; workload++)
+    {
+        for (ArrayGrowth growth = ARRAY_GROW_DOUBLE; growth <= ARRAY_GROW_FIXED; growth++)
+        {
+            measure(workload, growth, n);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "array.h"
+
+// Callback iteration through array_foreach against ARRAY_FOREACH and the bulk
+// operations.
+// Build with make bench_iteration, which compiles it with -O3 -march=native
+//
+// Usage: ./bench_iteration [elements] [repetitions]   (default 1e7, 20)
+
+static long callbackSum;
+static long callbackMax;
+
+static void sum_cb(long x) { callbackSum += x; }
+static void max_cb(long x) { if (x > callbackMax) callbackMax = x; }
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double seconds, long n, int repetitions, double baseline, long check)
+{
+    double ns = seconds * 1e9 / ((double)n * repetitions);
+    printf("%-28s %8.3f ns/elem %7.1fx   (%ld)\n", name, ns, baseline > 0 ? baseline / ns : 1.0, check);
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    int repetitions = argc > 2 ? atoi(argv[2]) : 20;
+
+    Array a = array_new(n);
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(&a, (i * 7919) % 1000003);
+    }
+
+    double start, baseline;
+    long check = 0;
+
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        callbackSum = 0;
+        array_foreach(a, sum_cb);
+        check += callbackSum;
+    }
+    baseline = (now() - start) * 1e9 / ((double)n * repetitions);
+    report("sum: array_foreach", (now() - start), n, repetitions, 0, check);
+
+    check = 0;
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        long sum = 0;
+        ARRAY_FOREACH(x, a)
+        {
+            sum += x;
+        }
+        check += sum;
+    }
+    report("sum: ARRAY_FOREACH", now() - start, n, repetitions, baseline, check);
+
+    check = 0;
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        check += array_sum(a);
+    }
+    report("sum: array_sum", now() - start, n, repetitions, baseline, check);
+
+    check = 0;
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        callbackMax = array_front(a);
+        array_foreach(a, max_cb);
+        check += callbackMax;
+    }
+    baseline = (now() - start) * 1e9 / ((double)n * repetitions);
+    report("max: array_foreach", now() - start, n, repetitions, 0, check);
+
+    check = 0;
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        check += array_max(a);
+    }
+    report("max: array_max", now() - start, n, repetitions, baseline, check);
+
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        for (long i = 0; i < array_length(a); i++)
+        {
+            a.data[a.front + i] += 1;
+        }
+    }
+    baseline = (now() - start) * 1e9 / ((double)n * repetitions);
+    report("add: indexed loop", now() - start, n, repetitions, 0, array_front(a));
+
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        array_addScalar(&a, -1);
+    }
+    report("add: array_addScalar", now() - start, n, repetitions, baseline, array_front(a));
+
+    start = now();
+    for (int r = 0; r < repetitions; r++)
+    {
+        array_fill(&a, r + 1);
+    }
+    report("fill: array_fill", now() - start, n, repetitions, 0, array_back(a));
+
+    // Filtering removes elements, so work on a fresh copy each time
+    double filterSeconds = 0;
+    long removed = 0;
+    for (int r = 0; r < repetitions; r++)
+    {
+        a.back = a.front;
+        for (long i = 0; i < n; i++)
+        {
+            array_insertBack(&a, (i * 7919) % 1000003);
+        }
+        start = now();
+        removed += array_filterRange(&a, 250000, 750000);
+        filterSeconds += now() - start;
+    }
+    report("filter: array_filterRange", filterSeconds, n, repetitions, 0, removed);
+
+    array_destroy(a);
+    return 0;
+}
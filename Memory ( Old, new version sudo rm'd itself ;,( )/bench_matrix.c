@@ -0,0 +1,198 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "matrix.h"
+
+// The task_a matrix as one malloc per row against matrix_new with one block and
+// with hugepages, for several x_dim at the same total size. Reports allocation
+// time, RSS beyond the payload once every element is written, and the bandwidth
+// of summing row by row and column by column. Each case runs in its own process.
+// Build with make bench_matrix
+//
+// Usage: ./bench_matrix [megabytes]   (default 256, the exercise uses 4000)
+
+enum layout
+{
+    ROWS_MALLOC, // task_a.c
+    BLOCK,
+    BLOCK_HUGE,
+    LAYOUT_COUNT
+};
+
+static const char *layoutString[] = {"malloc rows", "block", "block huge"};
+
+static const long xDims[] = {10, 100, 1000, 10000, 100000};
+
+struct Result
+{
+    double allocSeconds;
+    double overheadMB;
+    double rowGBs;
+    double columnGBs;
+    double freeSeconds;
+    int hugetlb;
+};
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static long rss_kb(void)
+{
+    FILE *status = fopen("/proc/self/status", "r");
+    char line[256];
+    long kb = 0;
+    while (status != NULL && fgets(line, sizeof(line), status) != NULL)
+    {
+        if (sscanf(line, "VmRSS: %ld", &kb) == 1)
+        {
+            break;
+        }
+    }
+    if (status != NULL)
+    {
+        fclose(status);
+    }
+    return kb;
+}
+
+// The volatile sink keeps the sums from being optimised away
+static volatile long sink;
+
+static struct Result run(enum layout layout, long x_dim, long y_dim)
+{
+    struct Result result = {0};
+    double payload = (double)sizeof(long) * x_dim * y_dim;
+    long **rows = NULL;
+    Matrix m = {0};
+    long rssBefore = rss_kb();
+
+    double start = now();
+    if (layout == ROWS_MALLOC)
+    {
+        rows = malloc(y_dim * sizeof(long *));
+        for (long y = 0; rows != NULL && y < y_dim; y++)
+        {
+            rows[y] = malloc(x_dim * sizeof(long));
+            if (rows[y] == NULL)
+            {
+                exit(1);
+            }
+        }
+    }
+    else
+    {
+        m = matrix_new(x_dim, y_dim, MATRIX_ROWS | (layout == BLOCK_HUGE ? MATRIX_HUGEPAGES : 0));
+        rows = m.rows;
+        result.hugetlb = (m.flags & MATRIX_HUGETLB) != 0;
+    }
+    result.allocSeconds = now() - start;
+    if (rows == NULL)
+    {
+        exit(1);
+    }
+
+    for (long y = 0; y < y_dim; y++)
+    {
+        for (long x = 0; x < x_dim; x++)
+        {
+            rows[y][x] = x + y;
+        }
+    }
+    result.overheadMB = ((rss_kb() - rssBefore) * 1024.0 - payload) / (1024 * 1024);
+
+    long sum = 0;
+    start = now();
+    for (long y = 0; y < y_dim; y++)
+    {
+        for (long x = 0; x < x_dim; x++)
+        {
+            sum += rows[y][x];
+        }
+    }
+    result.rowGBs = payload / (now() - start) / 1e9;
+
+    start = now();
+    for (long x = 0; x < x_dim; x++)
+    {
+        for (long y = 0; y < y_dim; y++)
+        {
+            sum += rows[y][x];
+        }
+    }
+    result.columnGBs = payload / (now() - start) / 1e9;
+    sink = sum;
+
+    start = now();
+    if (layout == ROWS_MALLOC)
+    {
+        for (long y = 0; y < y_dim; y++)
+        {
+            free(rows[y]);
+        }
+        free(rows);
+    }
+    else
+    {
+        matrix_destroy(m);
+    }
+    result.freeSeconds = now() - start;
+    return result;
+}
+
+static void measure(enum layout layout, long x_dim, long y_dim)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        struct Result result = run(layout, x_dim, y_dim);
+        _exit(write(fds[1], &result, sizeof(result)) == sizeof(result) ? 0 : 1);
+    }
+
+    struct Result result;
+    int status;
+    close(fds[1]);
+    long got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+
+    if (got != sizeof(result))
+    {
+        printf("%-12s %8ld  failed (out of memory?)\n", layoutString[layout], x_dim);
+        return;
+    }
+
+    printf("%-12s %8ld %10.4f %12.1f %10.2f %10.2f %10.4f%s\n", layoutString[layout], x_dim, result.allocSeconds,
+           result.overheadMB, result.rowGBs, result.columnGBs, result.freeSeconds,
+           layout == BLOCK_HUGE ? (result.hugetlb ? "  (hugetlb)" : "  (THP)") : "");
+}
+
+int main(int argc, char *argv[])
+{
+    long megabytes = argc > 1 ? atol(argv[1]) : 256;
+    long xy_size = megabytes * 1024 * 1024 / sizeof(long);
+
+    printf("%ld MB of longs\n", megabytes);
+    printf("%-12s %8s %10s %12s %10s %10s %10s\n", "layout", "x_dim", "alloc s", "overhead MB", "row GB/s", "col GB/s", "free s");
+    for (size_t i = 0; i < sizeof(xDims) / sizeof(xDims[0]); i++)
+    {
+        for (enum layout layout = ROWS_MALLOC; layout < LAYOUT_COUNT; layout++)
+        {
+            measure(layout, xDims[i], xy_size / xDims[i]);
+        }
+    }
+    return 0;
+}
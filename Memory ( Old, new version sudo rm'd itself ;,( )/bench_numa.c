@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "array.h"
+#include "matrix.h"
+
+// Memory bandwidth by NUMA placement. First one thread on the CPUs of each node,
+// reading and writing an Array bound to each node (local and remote) and one
+// interleaved over all of them. Then all cores reading an Array that one thread
+// filled, one that array_parallelResize filled (first touch by the pool's threads),
+// one interleaved, and an interleaved Matrix. With a single node there is nothing
+// remote to measure: the remote rows are skipped and the rest still runs. The all
+// core reads split the array evenly over one thread per core, the same split
+// array_parallelResize starts its threads with, and each sums its part with array_sum.
+// Build with make bench_numa
+//
+// Usage: ./bench_numa [megabytes]   (default 1024)
+
+#define REPEATS 5
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// The CPUs of a node from a list like "0-3,8-11", all CPUs if there is no such file
+static void node_cpus(int node, cpu_set_t *set)
+{
+    char path[64], list[1024];
+    CPU_ZERO(set);
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *f = fopen(path, "r");
+    if (f == NULL || fgets(list, sizeof(list), f) == NULL)
+    {
+        sched_getaffinity(0, sizeof(*set), set);
+        if (f != NULL)
+        {
+            fclose(f);
+        }
+        return;
+    }
+    fclose(f);
+    for (char *p = list; *p != '\0' && *p != '\n';)
+    {
+        char *end;
+        long first = strtol(p, &end, 10), last = first;
+        if (*end == '-')
+        {
+            last = strtol(end + 1, &end, 10);
+        }
+        for (long c = first; c <= last && c < CPU_SETSIZE; c++)
+        {
+            CPU_SET(c, set);
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+}
+
+// The volatile sink keeps the sums from being optimised away
+static volatile long sink;
+
+struct Part
+{
+    pthread_t thread;
+    Array view;
+    long sum;
+};
+
+static void *sum_part(void *arg)
+{
+    struct Part *part = arg;
+    part->sum = array_sum(part->view);
+    return NULL;
+}
+
+static long parallel_sum(Array a)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    struct Part *parts = malloc(sizeof(struct Part) * threads);
+    for (int t = 0; t < threads; t++)
+    {
+        parts[t].view = a;
+        parts[t].view.front = array_length(a) * t / threads;
+        parts[t].view.back = array_length(a) * (t + 1) / threads;
+        pthread_create(&parts[t].thread, NULL, sum_part, &parts[t]);
+    }
+    long sum = 0;
+    for (int t = 0; t < threads; t++)
+    {
+        pthread_join(parts[t].thread, NULL);
+        sum += parts[t].sum;
+    }
+    free(parts);
+    return sum;
+}
+
+// Best of REPEATS, in GB/s
+static double read_rate(Array a, int parallel)
+{
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        double start = now();
+        sink = parallel ? parallel_sum(a) : array_sum(a);
+        double rate = sizeof(long) * array_length(a) / (now() - start) / 1e9;
+        best = rate > best ? rate : best;
+    }
+    return best;
+}
+
+static double write_rate(Array *a)
+{
+    double best = 0;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        double start = now();
+        array_fill(a, r);
+        double rate = sizeof(long) * array_length(*a) / (now() - start) / 1e9;
+        best = rate > best ? rate : best;
+    }
+    return best;
+}
+
+// Runs in a child pinned to the CPUs of cpuNode, writes read and write GB/s to fd
+static void measure_single(long n, int cpuNode, unsigned policy, int memNode, int fd)
+{
+    cpu_set_t set;
+    node_cpus(cpuNode, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+
+    RealtimeAllocator placed;
+    realtime_init(&placed, policy);
+    placed.node = memNode;
+    Array a = array_newWith(n, &placed.base);
+    array_resize(&a, n, 1);
+    double rates[3] = {read_rate(a, 0), write_rate(&a), placed.placeFailures};
+    array_destroy(a);
+    if (write(fd, rates, sizeof(rates)) != sizeof(rates))
+    {
+        _exit(1);
+    }
+}
+
+static void single(long n, int cpuNode, unsigned policy, int memNode, const char *placement)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        return;
+    }
+    if (fork() == 0)
+    {
+        close(fds[0]);
+        measure_single(n, cpuNode, policy, memNode, fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    double rates[3];
+    int ok = read(fds[0], rates, sizeof(rates)) == sizeof(rates);
+    close(fds[0]);
+    wait(NULL);
+    if (ok)
+    {
+        printf("%8d %-14s %10.2f %10.2f%s\n", cpuNode, placement, rates[0], rates[1],
+               rates[2] > 0 ? "  (placement refused)" : "");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long megabytes = argc > 1 ? atol(argv[1]) : 1024;
+    long n = megabytes * 1000000 / sizeof(long);
+    int nodes = allocator_numaNodes();
+
+    printf("%ld MB, %d NUMA node%s, %ld cores\n", megabytes, nodes, nodes == 1 ? "" : "s", sysconf(_SC_NPROCESSORS_ONLN));
+    if (nodes == 1)
+    {
+        printf("Single node: no remote memory, every placement below is local\n");
+    }
+
+    printf("\nOne thread\n%8s %-14s %10s %10s\n", "cpu node", "memory", "read GB/s", "write GB/s");
+    for (int cpu = 0; cpu < nodes; cpu++)
+    {
+        for (int mem = 0; mem < nodes; mem++)
+        {
+            char placement[32];
+            snprintf(placement, sizeof(placement), "node %d %s", mem, mem == cpu ? "local" : "remote");
+            single(n, cpu, ALLOCATOR_BIND, mem, placement);
+        }
+        single(n, cpu, ALLOCATOR_INTERLEAVE, 0, "interleaved");
+    }
+
+    // All cores from here on, the pool is started with the full affinity mask
+    printf("\nAll cores\n%-22s %10s %10s\n", "placement", "fill s", "read GB/s");
+
+    double start = now();
+    Array a = array_new(1);
+    array_resize(&a, n, 1);
+    double fill = now() - start;
+    printf("%-22s %10.3f %10.2f\n", "one thread filled", fill, read_rate(a, 1));
+    array_destroy(a);
+
+    start = now();
+    a = array_new(1);
+    array_parallelResize(&a, n, 1, 0);
+    fill = now() - start;
+    printf("%-22s %10.3f %10.2f\n", "parallel first touch", fill, read_rate(a, 1));
+    array_destroy(a);
+
+    RealtimeAllocator interleaved;
+    realtime_init(&interleaved, ALLOCATOR_INTERLEAVE);
+    start = now();
+    a = array_newWith(n, &interleaved.base);
+    array_parallelResize(&a, n, 1, 0);
+    fill = now() - start;
+    printf("%-22s %10.3f %10.2f\n", "interleaved", fill, read_rate(a, 1));
+    array_destroy(a);
+
+    start = now();
+    Matrix m = matrix_new(1000, n / 1000, MATRIX_INTERLEAVE | MATRIX_PREFAULT);
+    fill = now() - start;
+    if (m.data != NULL)
+    {
+        // A view of the matrix block as an Array, for the parallel read
+        Array view = {.data = m.data, .front = 0, .back = m.x_dim * m.y_dim, .capacity = m.x_dim * m.y_dim};
+        printf("%-22s %10.3f %10.2f%s\n", "interleaved matrix", fill, read_rate(view, 1),
+               m.flags & MATRIX_INTERLEAVE ? "" : "  (placement refused)");
+        matrix_destroy(m);
+    }
+    return 0;
+}
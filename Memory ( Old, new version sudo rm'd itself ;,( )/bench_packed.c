@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "array.h"
+#include "parray.h"
+
+// PackedArray against the plain Array on three kinds of data: small values,
+// sorted timestamps with gaps of up to a millisecond, and random 64 bit values
+// that do not compress. Reports the compression ratio, the time to build the
+// packed array, a sequential sum in GB/s of the elements it stands for (and of
+// the bytes it actually reads), and random single-element reads.
+// Build with make bench_packed
+//
+// Usage: ./bench_packed [elements]   (default 5e7)
+
+#define REPEATS 5
+#define READS 1000000
+
+static unsigned long long rngState = 4147;
+
+static long bench_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (long)(rngState * 0x2545F4914F6CDD1DULL);
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// The volatile sink keeps the reads from being optimised away
+static volatile long sink;
+
+static long generate(int kind, long i, long *clock)
+{
+    (void)i;
+    switch (kind)
+    {
+    case 0:
+        return (unsigned long)bench_random() % 1000;
+    case 1:
+        *clock += 1 + (unsigned long)bench_random() % 1000000;
+        return *clock;
+    default:
+        return bench_random();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 50000000L;
+    const char *kinds[] = {"small", "timestamps", "random"};
+
+    printf("%ld elements, GB/s of plain longs scanned (packed GB/s is the bytes read)\n", n);
+    printf("%-11s %7s %9s %10s %11s %11s %9s %9s\n", "data", "ratio", "pack Me/s", "Array GB/s", "packed GB/s",
+           "(read GB/s)", "Array ns", "packed ns");
+    for (int kind = 0; kind < 3; kind++)
+    {
+        long clock = 1700000000000000000L;
+        Array a = array_new(n);
+        for (long i = 0; i < n; i++)
+        {
+            array_insertBack(&a, generate(kind, i, &clock));
+        }
+
+        PackedArray p;
+        parray_init(&p);
+        double start = now();
+        parray_appendArray(&p, a);
+        double pack = now() - start;
+
+        double arrayBest = 1e9, packedBest = 1e9;
+        for (int r = 0; r < REPEATS; r++)
+        {
+            start = now();
+            long expected = array_sum(a);
+            double t = now() - start;
+            arrayBest = t < arrayBest ? t : arrayBest;
+
+            start = now();
+            long sum = parray_sum(&p);
+            t = now() - start;
+            packedBest = t < packedBest ? t : packedBest;
+            if (sum != expected)
+            {
+                printf("WRONG RESULT\n");
+            }
+        }
+
+        long *indices = malloc(sizeof(long) * READS);
+        for (long i = 0; i < READS; i++)
+        {
+            indices[i] = (unsigned long)bench_random() % n;
+        }
+        start = now();
+        for (long i = 0; i < READS; i++)
+        {
+            sink = a.data[indices[i]];
+        }
+        double arrayRead = now() - start;
+        start = now();
+        for (long i = 0; i < READS; i++)
+        {
+            sink = parray_get(&p, indices[i]);
+        }
+        double packedRead = now() - start;
+        free(indices);
+
+        double bytes = sizeof(long) * (double)n;
+        printf("%-11s %7.2f %9.1f %10.2f %11.2f %11.2f %9.1f %9.1f\n", kinds[kind], bytes / parray_bytes(&p),
+               n / pack / 1e6, bytes / arrayBest / 1e9, bytes / packedBest / 1e9, parray_bytes(&p) / packedBest / 1e9,
+               arrayRead * 1e9 / READS, packedRead * 1e9 / READS);
+
+        parray_destroy(&p);
+        array_destroy(a);
+    }
+    return 0;
+}
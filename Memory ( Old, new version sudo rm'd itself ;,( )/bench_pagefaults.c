@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "matrix.h"
+
+// Measures what Task A asks you to watch in the task manager. The matrix is
+// allocated (as in task_a.c, or as one block), then read one word per page, then
+// memset, then freed. After every phase the page faults from getrusage, RSS and
+// swap from /proc/self/status, and the breakdown in /proc/self/smaps_rollup are
+// recorded. Each x_dim runs in its own process, which sends every sample as soon as
+// its phase is done, so a run the OOM killer stops still shows how far it got.
+// Results go to stdout and as CSV to the file given (pagefaults.csv by default).
+// Build with make bench_pagefaults
+//
+// Usage: ./bench_pagefaults [megabytes] [rows|block] [file]   (default 1024 rows)
+
+enum phase
+{
+    ALLOCATE,
+    TOUCH, // Read one word per page: faults in the shared zero page, nothing is committed
+    MEMSET,
+    FREE,
+    PHASE_COUNT
+};
+
+static const char *phaseString[] = {"allocate", "touch", "memset", "free"};
+
+static const long xDims[] = {100, 1000, 10000};
+
+struct Sample
+{
+    double seconds;
+    long minorFaults;
+    long majorFaults;
+    long vmSizeKb;
+    long rssKb;
+    long swapKb;
+    long pssKb;
+    long anonymousKb;
+    long anonHugeKb;
+};
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// Pick "Name: value kB" lines out of a /proc file
+static void read_fields(const char *path, const char **names, long **values, int count)
+{
+    FILE *file = fopen(path, "r");
+    char line[256];
+    while (file != NULL && fgets(line, sizeof(line), file) != NULL)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            size_t length = strlen(names[i]);
+            if (strncmp(line, names[i], length) == 0 && line[length] == ':')
+            {
+                *values[i] = atol(line + length + 1);
+            }
+        }
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+}
+
+static void sample(struct Sample *s, double start)
+{
+    struct rusage usage;
+    s->seconds = now() - start;
+    getrusage(RUSAGE_SELF, &usage);
+    s->minorFaults = usage.ru_minflt;
+    s->majorFaults = usage.ru_majflt;
+
+    const char *statusNames[] = {"VmSize", "VmRSS", "VmSwap"};
+    long *statusValues[] = {&s->vmSizeKb, &s->rssKb, &s->swapKb};
+    read_fields("/proc/self/status", statusNames, statusValues, 3);
+
+    // smaps_rollup needs Linux 4.14, the columns stay at -1 without it
+    s->pssKb = s->anonymousKb = s->anonHugeKb = -1;
+    const char *rollupNames[] = {"Pss", "Anonymous", "AnonHugePages"};
+    long *rollupValues[] = {&s->pssKb, &s->anonymousKb, &s->anonHugeKb};
+    read_fields("/proc/self/smaps_rollup", rollupNames, rollupValues, 3);
+}
+
+static void send(int fd, struct Sample *s)
+{
+    if (write(fd, s, sizeof(*s)) != sizeof(*s))
+    {
+        _exit(1);
+    }
+}
+
+static void run(int fd, int block, long x_dim, long y_dim)
+{
+    struct Sample s;
+    long pageLongs = sysconf(_SC_PAGESIZE) / sizeof(long);
+    long **matrix;
+    Matrix m = {0};
+    volatile long sink = 0;
+
+    // Faults before the allocation, so the first phase is a difference like the others
+    sample(&s, now());
+    send(fd, &s);
+
+    double start = now();
+    if (block)
+    {
+        m = matrix_new(x_dim, y_dim, MATRIX_ROWS);
+        matrix = m.rows;
+    }
+    else
+    {
+        matrix = malloc(y_dim * sizeof(long *));
+        for (long y = 0; matrix != NULL && y < y_dim; y++)
+        {
+            matrix[y] = malloc(x_dim * sizeof(long));
+            if (matrix[y] == NULL)
+            {
+                _exit(1);
+            }
+        }
+    }
+    if (matrix == NULL)
+    {
+        _exit(1);
+    }
+    sample(&s, start);
+    send(fd, &s);
+
+    start = now();
+    for (long y = 0; y < y_dim; y++)
+    {
+        for (long x = 0; x < x_dim; x += pageLongs)
+        {
+            sink += matrix[y][x];
+        }
+    }
+    sample(&s, start);
+    send(fd, &s);
+
+    start = now();
+    for (long y = 0; y < y_dim; y++)
+    {
+        memset(matrix[y], 0, x_dim * sizeof(long));
+    }
+    sample(&s, start);
+    send(fd, &s);
+
+    start = now();
+    if (block)
+    {
+        matrix_destroy(m);
+    }
+    else
+    {
+        for (long y = 0; y < y_dim; y++)
+        {
+            free(matrix[y]);
+        }
+        free(matrix);
+    }
+    sample(&s, start);
+    send(fd, &s);
+    (void)sink;
+}
+
+static void measure(FILE *output, int block, long x_dim, long y_dim)
+{
+    struct Sample previous, s;
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        perror("pipe");
+        exit(1);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fds[0]);
+        run(fds[1], block, x_dim, y_dim);
+        _exit(0);
+    }
+    close(fds[1]);
+
+    // The phases that finished are printed, the first one missing is where the child died
+    enum phase p = ALLOCATE;
+    if (read(fds[0], &previous, sizeof(previous)) == sizeof(previous))
+    {
+        for (; p < PHASE_COUNT && read(fds[0], &s, sizeof(s)) == sizeof(s); p++)
+        {
+            long minor = s.minorFaults - previous.minorFaults;
+            long major = s.majorFaults - previous.majorFaults;
+            previous = s;
+
+            printf("%-6s %6ld %-9s %9.4f %10ld %7ld %10ld %10ld %8ld %10ld\n", block ? "block" : "rows", x_dim,
+                   phaseString[p], s.seconds, minor, major, s.vmSizeKb / 1024, s.rssKb / 1024, s.swapKb / 1024,
+                   s.anonHugeKb < 0 ? -1 : s.anonHugeKb / 1024);
+            fprintf(output, "%s,%ld,%s,%.6f,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld\n", block ? "block" : "rows", x_dim,
+                    phaseString[p], s.seconds, minor, major, s.vmSizeKb, s.rssKb, s.swapKb, s.pssKb,
+                    s.anonymousKb, s.anonHugeKb);
+        }
+    }
+    close(fds[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    if (p < PHASE_COUNT)
+    {
+        printf("%-6s %6ld %-9s  failed (%s)\n", block ? "block" : "rows", x_dim, phaseString[p],
+               WIFSIGNALED(status) ? "killed, out of memory?" : "allocation failed");
+        fprintf(output, "%s,%ld,%s,failed,,,,,,,,\n", block ? "block" : "rows", x_dim, phaseString[p]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    long megabytes = argc > 1 ? atol(argv[1]) : 1024;
+    int block = argc > 2 && strcmp(argv[2], "block") == 0;
+    const char *outputName = argc > 3 ? argv[3] : "pagefaults.csv";
+    long xy_size = megabytes * 1000 * 1000 / sizeof(long);
+
+    FILE *output = fopen(outputName, "w");
+    if (output == NULL)
+    {
+        perror("Failed to open results file");
+        exit(EXIT_FAILURE);
+    }
+
+    long overcommit = -1;
+    FILE *setting = fopen("/proc/sys/vm/overcommit_memory", "r");
+    if (setting != NULL)
+    {
+        if (fscanf(setting, "%ld", &overcommit) != 1)
+        {
+            overcommit = -1;
+        }
+        fclose(setting);
+    }
+    printf("%ld MB, vm.overcommit_memory = %ld\n", megabytes, overcommit);
+
+    fprintf(output, "layout,x_dim,phase,seconds,minor_faults,major_faults,vm_size_kb,rss_kb,swap_kb,pss_kb,anonymous_kb,anon_huge_kb\n");
+    printf("%-6s %6s %-9s %9s %10s %7s %10s %10s %8s %10s\n", "layout", "x_dim", "phase", "seconds",
+           "minflt", "majflt", "VmSize MB", "RSS MB", "swap MB", "THP MB");
+    for (size_t i = 0; i < sizeof(xDims) / sizeof(xDims[0]); i++)
+    {
+        measure(output, block, xDims[i], xy_size / xDims[i]);
+    }
+
+    printf("Results written to %s\n", outputName);
+    fclose(output);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "array.h"
+
+// array_parallelForeach and array_parallelReduce with a callback that does some
+// arithmetic per element, against array_foreach, on 1, 2, 4, ... cores. Each core
+// count runs in a child process limited with sched_setaffinity, since the pool is
+// sized when first used. Then the grain sizes on all cores, with a cheap callback
+// where the per-chunk overhead shows.
+// Build with make bench_parallel
+//
+// Usage: ./bench_parallel [elements] [work]   (default 1e7, 100 rounds per element)
+
+static long work;
+
+// The volatile sink keeps the callbacks from being optimised away
+static volatile long sink;
+
+static long heavy(long x)
+{
+    for (long i = 0; i < work; i++)
+    {
+        x ^= x << 13;
+        x ^= (unsigned long)x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+static void heavy_cb(long x) { sink = heavy(x); }
+static long light(long x) { return x; }
+static long plus(long a, long b) { return a + b; }
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void use_cores(int cores)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0; c < cores; c++)
+    {
+        CPU_SET(c, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Runs in the child, writes the element rates to the pipe
+static void measure(Array a, int cores, int fd)
+{
+    use_cores(cores);
+    long n = array_length(a);
+    double rates[3];
+
+    double start = now();
+    array_foreach(a, heavy_cb);
+    rates[0] = n / (now() - start) / 1e6;
+
+    start = now();
+    array_parallelForeach(a, heavy_cb, 0);
+    rates[1] = n / (now() - start) / 1e6;
+
+    start = now();
+    sink = array_parallelReduce(a, 0, heavy, plus, 0);
+    rates[2] = n / (now() - start) / 1e6;
+
+    write(fd, rates, sizeof(rates));
+}
+
+static void measure_grain(Array a, long grain, int fd)
+{
+    long n = array_length(a);
+    double start = now();
+    long sum = array_parallelReduce(a, 0, light, plus, grain);
+    double rate = n / (now() - start) / 1e6;
+    if (sum != array_sum(a))
+    {
+        rate = -1;
+    }
+    write(fd, &rate, sizeof(rate));
+}
+
+// Fork so every case gets a fresh pool
+static void run(Array a, int cores, long grain, double *rates, size_t bytes)
+{
+    int fds[2];
+    pipe(fds);
+    if (fork() == 0)
+    {
+        close(fds[0]);
+        if (grain > 0)
+        {
+            measure_grain(a, grain, fds[1]);
+        }
+        else
+        {
+            measure(a, cores, fds[1]);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    read(fds[0], rates, bytes);
+    close(fds[0]);
+    wait(NULL);
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    work = argc > 2 ? atol(argv[2]) : 100;
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    Array a = array_new(1);
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(&a, i);
+    }
+
+    printf("%ld elements, %ld rounds of work per element\n", n, work);
+    printf("%6s %12s %14s %14s %8s\n", "cores", "foreach Me/s", "parallel Me/s", "reduce Me/s", "speedup");
+    for (int c = 1; c <= cores; c *= 2)
+    {
+        double rates[3];
+        run(a, c, 0, rates, sizeof(rates));
+        printf("%6d %12.2f %14.2f %14.2f %8.2f\n", c, rates[0], rates[1], rates[2], rates[1] / rates[0]);
+    }
+
+    printf("\n%10s %12s   (sum, all %d cores)\n", "grain", "reduce Me/s", cores);
+    for (long grain = 64; grain <= 1048576; grain *= 4)
+    {
+        double rate;
+        run(a, cores, grain, &rate, sizeof(rate));
+        printf("%10ld %12.1f%s\n", grain, rate, rate < 0 ? "  WRONG RESULT" : "");
+    }
+
+    array_destroy(a);
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "array.h"
+#include "sarray.h"
+
+// Latency of every single append up to a large size: SegmentedArray against the
+// doubling Array on the system allocator (which grows large blocks with mremap)
+// and on an allocator that copies on every growth, as the exercise's dynamic_arr
+// does. Latencies go into a histogram of power of two buckets. Moves counts how
+// often the element at index 0 changed address. Then random reads, with sarray_get
+// and straight from a.data, to show what the chunk lookup costs. Each case runs in
+// a child process.
+// Build with make bench_segmented
+//
+// Usage: ./bench_segmented [elements]   (default 5e7)
+
+#define BUCKETS 40
+#define READS 10000000
+
+struct Result
+{
+    double seconds;
+    long histogram[BUCKETS];
+    long max;
+    long moves;
+    double getNs;
+};
+
+// Allocate, copy, free on every growth
+static void *copying_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    void *newData = self->allocate(self, newBytes);
+    if (newData != NULL)
+    {
+        memcpy(newData, data, keep < newBytes ? keep : newBytes);
+        self->release(self, data, bytes);
+    }
+    return newData;
+}
+
+static void *copying_allocate(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return allocator_system()->allocate(allocator_system(), bytes);
+}
+
+static void copying_release(Allocator *self, void *data, size_t bytes)
+{
+    (void)self;
+    allocator_system()->release(allocator_system(), data, bytes);
+}
+
+static size_t copying_usable(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return allocator_system()->usable(allocator_system(), bytes);
+}
+
+static Allocator copying = {"copying", copying_allocate, copying_resize, copying_release, copying_usable};
+
+static long now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000L + t.tv_nsec;
+}
+
+static void record(struct Result *r, long ns)
+{
+    int bucket = ns > 0 ? 64 - __builtin_clzl((unsigned long)ns) : 0;
+    r->histogram[bucket < BUCKETS ? bucket : BUCKETS - 1]++;
+    r->max = ns > r->max ? ns : r->max;
+}
+
+// Upper bound of the bucket holding the given fraction of appends
+static long percentile(struct Result *r, long n, double fraction)
+{
+    long seen = 0;
+    for (int b = 0; b < BUCKETS; b++)
+    {
+        seen += r->histogram[b];
+        if (seen >= fraction * n)
+        {
+            return 1L << b;
+        }
+    }
+    return r->max;
+}
+
+// The volatile sink keeps the reads from being optimised away
+static volatile long sink;
+
+static void run(int which, long n, struct Result *r)
+{
+    unsigned long state = 4147;
+    long *first = NULL;
+    if (which == 0)
+    {
+        SegmentedArray s;
+        sarray_init(&s);
+        double start = now_ns();
+        for (long i = 0; i < n; i++)
+        {
+            long t = now_ns();
+            sarray_insertBack(&s, i);
+            record(r, now_ns() - t);
+            if (first != sarray_at(&s, 0))
+            {
+                r->moves += first != NULL;
+                first = sarray_at(&s, 0);
+            }
+        }
+        r->seconds = (now_ns() - start) / 1e9;
+
+        long t = now_ns();
+        for (long i = 0; i < READS; i++)
+        {
+            state = state * 6364136223846793005UL + 1442695040888963407UL;
+            sink = sarray_get(&s, (long)((state >> 16) % (unsigned long)n));
+        }
+        r->getNs = (double)(now_ns() - t) / READS;
+        sarray_destroy(&s);
+        return;
+    }
+
+    Array a = array_newWith(1, which == 1 ? allocator_system() : &copying);
+    double start = now_ns();
+    for (long i = 0; i < n; i++)
+    {
+        long t = now_ns();
+        array_insertBack(&a, i);
+        record(r, now_ns() - t);
+        if (first != a.data)
+        {
+            r->moves += first != NULL;
+            first = a.data;
+        }
+    }
+    r->seconds = (now_ns() - start) / 1e9;
+
+    long t = now_ns();
+    for (long i = 0; i < READS; i++)
+    {
+        state = state * 6364136223846793005UL + 1442695040888963407UL;
+        sink = a.data[(state >> 16) % (unsigned long)n];
+    }
+    r->getNs = (double)(now_ns() - t) / READS;
+    array_destroy(a);
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 50000000L;
+    const char *names[] = {"segmented", "Array", "Array copy"};
+
+    printf("%ld appends, latency bucket upper bounds in ns\n", n);
+    printf("%-11s %8s %8s %8s %8s %10s %10s %6s %7s\n", "array", "seconds", "p50", "p99", "p99.99", "p99.9999",
+           "max", "moves", "get ns");
+    for (int which = 0; which < 3; which++)
+    {
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            return 1;
+        }
+        if (fork() == 0)
+        {
+            struct Result r = {0};
+            close(fds[0]);
+            run(which, n, &r);
+            _exit(write(fds[1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+        }
+        close(fds[1]);
+        struct Result r;
+        int ok = read(fds[0], &r, sizeof(r)) == sizeof(r);
+        close(fds[0]);
+        wait(NULL);
+        if (!ok)
+        {
+            printf("%-11s failed\n", names[which]);
+            continue;
+        }
+        printf("%-11s %8.2f %8ld %8ld %8ld %10ld %10ld %6ld %7.1f\n", names[which], r.seconds, percentile(&r, n, 0.5),
+               percentile(&r, n, 0.99), percentile(&r, n, 0.9999), percentile(&r, n, 0.999999), r.max, r.moves,
+               r.getNs);
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "array.h"
+#include "iarray.h"
+
+// Create, append, read and destroy cycles of short arrays, with a heap buffer from
+// array_new against the inline buffer of an InlineArray. Allocations are counted
+// by an allocator that forwards to the system one.
+// Build with make bench_small
+//
+// Usage: ./bench_small [cycles]   (default 1e7)
+
+static long allocations;
+
+static void *counting_allocate(Allocator *self, size_t bytes)
+{
+    (void)self;
+    allocations++;
+    return allocator_system()->allocate(allocator_system(), bytes);
+}
+
+static void *counting_resize(Allocator *self, void *data, size_t bytes, size_t newBytes, size_t keep)
+{
+    (void)self;
+    allocations++;
+    return allocator_system()->resize(allocator_system(), data, bytes, newBytes, keep);
+}
+
+static void counting_release(Allocator *self, void *data, size_t bytes)
+{
+    (void)self;
+    allocator_system()->release(allocator_system(), data, bytes);
+}
+
+static size_t counting_usable(Allocator *self, size_t bytes)
+{
+    (void)self;
+    return allocator_system()->usable(allocator_system(), bytes);
+}
+
+static Allocator counting = {"counting", counting_allocate, counting_resize, counting_release, counting_usable};
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+// The volatile sink keeps the sums from being optimised away
+static volatile long sink;
+
+static void report(const char *name, long length, long cycles, double seconds)
+{
+    printf("%-8s %6ld %10.2f %12.3f\n", name, length, seconds * 1e9 / cycles, (double)allocations / cycles);
+}
+
+static void measure_heap(long length, long cycles)
+{
+    allocations = 0;
+    double start = now();
+    for (long c = 0; c < cycles; c++)
+    {
+        Array a = array_newWith(1, &counting);
+        for (long i = 0; i < length; i++)
+        {
+            array_insertBack(&a, c + i);
+        }
+        sink = array_sum(a);
+        array_destroy(a);
+    }
+    report("heap", length, cycles, now() - start);
+}
+
+static void measure_inline(long length, long cycles)
+{
+    allocations = 0;
+    double start = now();
+    for (long c = 0; c < cycles; c++)
+    {
+        InlineArray a;
+        iarray_initWith(&a, &counting);
+        for (long i = 0; i < length; i++)
+        {
+            iarray_insertBack(&a, c + i);
+        }
+        sink = iarray_sum(&a);
+        iarray_destroy(&a);
+    }
+    report("inline", length, cycles, now() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    long cycles = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+
+    printf("%ld cycles, sizeof(Array) = %zu, sizeof(InlineArray) = %zu, %d inline elements\n", cycles,
+           sizeof(Array), sizeof(InlineArray), IARRAY_CAPACITY);
+    printf("%-8s %6s %10s %12s\n", "array", "length", "ns/cycle", "allocs/cycle");
+    for (long length = 1; length <= 4 * IARRAY_CAPACITY; length *= 2)
+    {
+        measure_heap(length, cycles);
+        measure_inline(length, cycles);
+    }
+    return 0;
+}
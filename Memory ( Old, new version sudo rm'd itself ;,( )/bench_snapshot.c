@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "array.h"
+
+// Taking a stable copy of an array for a reader: a deep copy with array_appendArray
+// against array_snapshot, which shares the buffer. Then the first write to the
+// original after a snapshot, which pays for the copy, and the writes after that,
+// which do not.
+// Build with make bench_snapshot
+//
+// Usage: ./bench_snapshot [elements]   (default 1e7)
+
+#define ROUNDS 20
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    Array a = array_new(1);
+    array_resize(&a, n, 1);
+
+    printf("%ld elements, average of %d rounds\n", n, ROUNDS);
+    printf("%-22s %12s\n", "operation", "us");
+
+    double deep = 0, snapshot = 0, firstWrite = 0, laterWrite = 0;
+    int ok = 1;
+    for (int r = 0; r < ROUNDS; r++)
+    {
+        double start = now();
+        Array copy = array_new(n);
+        array_appendArray(&copy, a);
+        deep += now() - start;
+        array_destroy(copy);
+
+        start = now();
+        Array s = array_snapshot(&a);
+        snapshot += now() - start;
+
+        start = now();
+        array_insertBack(&a, r);
+        firstWrite += now() - start;
+
+        start = now();
+        array_insertBack(&a, r);
+        laterWrite += now() - start;
+
+        // The snapshot must still be the array as it was before the writes
+        ok &= array_length(s) == n + 2 * r && array_back(s) == (r > 0 ? r - 1 : 1);
+        array_destroy(s);
+    }
+
+    printf("%-22s %12.3f\n", "deep copy", deep * 1e6 / ROUNDS);
+    printf("%-22s %12.3f\n", "snapshot", snapshot * 1e6 / ROUNDS);
+    printf("%-22s %12.3f\n", "first write after", firstWrite * 1e6 / ROUNDS);
+    printf("%-22s %12.3f%s\n", "next write", laterWrite * 1e6 / ROUNDS, ok ? "" : "  WRONG RESULT");
+
+    array_destroy(a);
+    return 0;
+}
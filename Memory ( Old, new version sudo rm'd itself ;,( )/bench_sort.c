@@ -0,0 +1,159 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "array.h"
+
+// array_sort on random longs from 1e3 elements up, restricted to 1, 2, 4, ...
+// cores with sched_setaffinity (array_sort starts one thread per allowed core),
+// against qsort. Then lookups of random values with array_lowerBound against a
+// plain binary search with a branch, on the sorted array of each size.
+// Build with make bench_sort
+//
+// Usage: ./bench_sort [max_elements]   (default 1e8, 1e9 needs about 16 GB)
+
+#define LOOKUPS 1000000
+
+static unsigned long long rngState = 4147;
+
+static long bench_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (long)(rngState * 0x2545F4914F6CDD1DULL);
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static int compare_long(const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static void fill_random(Array *a, long n)
+{
+    array_resize(a, 0, 0);
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(a, bench_random());
+    }
+}
+
+// Sorts enough times to take a measurable while, the refill is not timed
+static double time_sort(Array *a, long n, int useQsort)
+{
+    double total = 0;
+    long rounds = 0;
+    do
+    {
+        fill_random(a, n);
+        double start = now();
+        if (useQsort)
+        {
+            qsort(a->data, n, sizeof(long), compare_long);
+        }
+        else
+        {
+            array_sort(a);
+        }
+        total += now() - start;
+        rounds++;
+    } while (total < 0.2);
+    return total / rounds;
+}
+
+static void use_cores(int cores)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c = 0, used = 0; used < cores && c < CPU_SETSIZE; c++)
+    {
+        if (CPU_ISSET(c, &set) == 0 && sysconf(_SC_NPROCESSORS_ONLN) > c)
+        {
+            CPU_SET(c, &set);
+            used++;
+        }
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+static long branchy_lowerBound(const long *data, long n, long value)
+{
+    long low = 0, high = n;
+    while (low < high)
+    {
+        long middle = low + (high - low) / 2;
+        if (data[middle] < value)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int main(int argc, char *argv[])
+{
+    long max = argc > 1 ? (long)atof(argv[1]) : 100000000L;
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long *queries = malloc(sizeof(long) * LOOKUPS);
+    Array a = array_new(1);
+
+    printf("%12s %6s %12s %12s %12s %12s\n", "elements", "cores", "sort Me/s", "qsort Me/s", "lb ns", "branchy ns");
+    for (long n = 1000; n <= max; n *= 10)
+    {
+        use_cores(cores);
+        double qsortSeconds = time_sort(&a, n, 1);
+
+        for (int c = 1; c <= cores; c *= 2)
+        {
+            use_cores(c);
+            double sortSeconds = time_sort(&a, n, 0);
+            printf("%12ld %6d %12.1f %12.1f", n, c, n / sortSeconds / 1e6, n / qsortSeconds / 1e6);
+
+            if (c > 1)
+            {
+                printf("\n");
+                continue;
+            }
+
+            // a is sorted now, look up values that are there and values that are not
+            for (long q = 0; q < LOOKUPS; q++)
+            {
+                queries[q] = q % 2 ? array_get(a, (unsigned long)bench_random() % n) : bench_random();
+            }
+            long found = 0;
+            double start = now();
+            for (long q = 0; q < LOOKUPS; q++)
+            {
+                found += array_lowerBound(a, queries[q]);
+            }
+            double lowerBound = now() - start;
+            start = now();
+            for (long q = 0; q < LOOKUPS; q++)
+            {
+                found -= branchy_lowerBound(a.data, n, queries[q]);
+            }
+            double branchy = now() - start;
+            printf(" %12.1f %12.1f%s\n", lowerBound * 1e9 / LOOKUPS, branchy * 1e9 / LOOKUPS,
+                   found == 0 ? "" : "  WRONG RESULT");
+        }
+    }
+
+    use_cores(cores);
+    array_destroy(a);
+    free(queries);
+    return 0;
+}
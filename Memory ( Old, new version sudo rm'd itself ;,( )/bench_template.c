@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "array.h"
+#include "array_template.h"
+
+// Arrays generated by ARRAY_DEFINE for int (the dynamic_arr element in
+// "sanntidssystemer oving 2.txt"), uint8_t and a small struct, against the long
+// Array: appends, a sequential sum and the bytes each one holds per element. A
+// ring of ints is also used as a queue, pushing at one end and popping at the other.
+// Build with make bench_template
+//
+// Usage: ./bench_template [elements]   (default 1e7)
+
+typedef struct
+{
+    float x;
+    float y;
+} Point;
+
+ARRAY_DEFINE(IntArray, int)
+ARRAY_DEFINE(ByteArray, uint8_t)
+ARRAY_DEFINE(PointArray, Point)
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void report(const char *name, long n, double appendSeconds, double sumSeconds, long capacity, size_t size,
+                   long sum, long expected)
+{
+    printf("%-10s %10.2f %10.2f %10.2f%s\n", name, appendSeconds * 1e9 / n, sumSeconds * 1e9 / n,
+           (double)capacity * size / n, sum == expected ? "" : "  WRONG RESULT");
+}
+
+int main(int argc, char *argv[])
+{
+    long n = argc > 1 ? (long)atof(argv[1]) : 10000000L;
+    long expectedInt = 0, expectedByte = 0;
+    for (long i = 0; i < n; i++)
+    {
+        expectedInt += (int)i;
+        expectedByte += (uint8_t)i;
+    }
+
+    printf("%ld elements\n", n);
+    printf("%-10s %10s %10s %10s\n", "array", "append ns", "sum ns", "bytes/elem");
+
+    Array a = array_new(1);
+    double start = now();
+    for (long i = 0; i < n; i++)
+    {
+        array_insertBack(&a, i);
+    }
+    double append = now() - start;
+    start = now();
+    long sum = array_sum(a);
+    report("Array", n, append, now() - start, a.capacity, sizeof(long), sum, n * (n - 1) / 2);
+    array_destroy(a);
+
+    IntArray ints = IntArray_new(1);
+    start = now();
+    for (long i = 0; i < n; i++)
+    {
+        IntArray_insertBack(&ints, (int)i);
+    }
+    append = now() - start;
+    start = now();
+    sum = 0;
+    for (long i = 0; i < IntArray_length(ints); i++)
+    {
+        sum += IntArray_get(ints, i);
+    }
+    report("int", n, append, now() - start, ints.capacity, sizeof(int), sum, expectedInt);
+    IntArray_destroy(ints);
+
+    ByteArray bytes = ByteArray_new(1);
+    start = now();
+    for (long i = 0; i < n; i++)
+    {
+        ByteArray_insertBack(&bytes, (uint8_t)i);
+    }
+    append = now() - start;
+    start = now();
+    sum = 0;
+    for (long i = 0; i < ByteArray_length(bytes); i++)
+    {
+        sum += ByteArray_get(bytes, i);
+    }
+    report("uint8_t", n, append, now() - start, bytes.capacity, sizeof(uint8_t), sum, expectedByte);
+    ByteArray_destroy(bytes);
+
+    PointArray points = PointArray_new(1);
+    start = now();
+    for (long i = 0; i < n; i++)
+    {
+        PointArray_insertBack(&points, (Point){(float)(i & 1023), 1.0f});
+    }
+    append = now() - start;
+    start = now();
+    sum = 0;
+    for (long i = 0; i < PointArray_length(points); i++)
+    {
+        Point *p = PointArray_at(points, i);
+        sum += (long)(p->x + p->y);
+    }
+    report("Point", n, append, now() - start, points.capacity, sizeof(Point), sum, n / 1024 * 523776 +
+           (n % 1024) * (n % 1024 - 1) / 2 + n);
+    PointArray_destroy(points);
+
+    // A queue that never holds more than 1024 ints, so the ring keeps reusing its slots
+    IntArray ring = IntArray_newRing(1024);
+    start = now();
+    sum = 0;
+    for (long i = 0; i < n; i++)
+    {
+        IntArray_insertBack(&ring, (int)i);
+        if (IntArray_length(ring) == 1024)
+        {
+            sum += IntArray_front(ring);
+            IntArray_popFront(&ring);
+        }
+    }
+    while (!IntArray_empty(ring))
+    {
+        sum += IntArray_front(ring);
+        IntArray_popFront(&ring);
+    }
+    double seconds = now() - start;
+    printf("%-10s %10.2f %10s %10s  (%ld slots)%s\n", "int ring", seconds * 1e9 / n, "-", "-", ring.capacity,
+           sum == expectedInt ? "" : "  WRONG RESULT");
+    IntArray_destroy(ring);
+    return 0;
+}
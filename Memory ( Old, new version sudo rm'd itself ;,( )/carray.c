@@ -0,0 +1,155 @@
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "carray.h"
+#include "segments.h"
+
+// Segments, laid out as in segments.h
+// A segment is its elements followed by one ready flag per element
+static size_t _carray_segmentBytes(int segment)
+{
+    return (sizeof(long) + sizeof(atomic_uchar)) * segment_length(segment, CARRAY_LOG_FIRST);
+}
+
+static atomic_uchar *_carray_ready(long *data, int segment)
+{
+    return (atomic_uchar *)(data + segment_length(segment, CARRAY_LOG_FIRST));
+}
+
+// Install a segment unless another thread got there first. Lock-free: every
+// thread that finds it missing allocates, one wins, the rest give theirs back.
+static long *_carray_install(ConcurrentArray *a, int segment)
+{
+    Allocator *system = allocator_system();
+    long *expected = NULL;
+    long *data = system->allocate(system, _carray_segmentBytes(segment));
+    assert(data != NULL);
+    memset(_carray_ready(data, segment), 0, sizeof(atomic_uchar) * segment_length(segment, CARRAY_LOG_FIRST));
+    if (!atomic_compare_exchange_strong(&a->segments[segment], &expected, data))
+    {
+        system->release(system, data, _carray_segmentBytes(segment));
+        return expected;
+    }
+    return data;
+}
+
+// Move committed past every slot that is ready. Any producer can do it for the
+// others: the one whose slot closes a gap carries committed over the slots that
+// were finished behind it, so the length never waits for a producer to return.
+static void _carray_commit(ConcurrentArray *a)
+{
+    long committed = atomic_load(&a->committed);
+    while (committed < atomic_load_explicit(&a->back, memory_order_relaxed))
+    {
+        int segment = segment_index(committed, CARRAY_LOG_FIRST);
+        long *data = atomic_load_explicit(&a->segments[segment], memory_order_acquire);
+        long offset = committed - segment_start(segment, CARRAY_LOG_FIRST);
+        if (data == NULL || !atomic_load(&_carray_ready(data, segment)[offset]))
+        {
+            return;
+        }
+        // On failure committed is reloaded, someone else moved it
+        if (atomic_compare_exchange_weak(&a->committed, &committed, committed + 1))
+        {
+            committed++;
+        }
+    }
+}
+
+// Construction / Destruction
+void carray_init(ConcurrentArray *a)
+{
+    atomic_init(&a->back, 0);
+    atomic_init(&a->committed, 0);
+    for (int s = 0; s < CARRAY_SEGMENTS; s++)
+    {
+        atomic_init(&a->segments[s], NULL);
+    }
+    _carray_install(a, 0);
+}
+
+void carray_destroy(ConcurrentArray *a)
+{
+    Allocator *system = allocator_system();
+    for (int s = 0; s < CARRAY_SEGMENTS; s++)
+    {
+        long *data = atomic_load(&a->segments[s]);
+        if (data != NULL)
+        {
+            system->release(system, data, _carray_segmentBytes(s));
+        }
+    }
+}
+
+// Modifiers
+long carray_insertBack(ConcurrentArray *a, long stuff)
+{
+    // Sequentially consistent, so a producer that commits its own slot and then
+    // finds back unchanged knows no later slot can be ready yet
+    long index = atomic_fetch_add(&a->back, 1);
+    int segment = segment_index(index, CARRAY_LOG_FIRST);
+    assert(segment < CARRAY_SEGMENTS);
+    long offset = index - segment_start(segment, CARRAY_LOG_FIRST);
+
+    long *data = atomic_load_explicit(&a->segments[segment], memory_order_acquire);
+    if (data == NULL)
+    {
+        data = _carray_install(a, segment);
+    }
+
+    // Whoever takes the middle slot of a segment sets up the next one, so producers
+    // reaching the end rarely find it missing
+    if (offset == segment_length(segment, CARRAY_LOG_FIRST) / 2 && segment + 1 < CARRAY_SEGMENTS &&
+        atomic_load_explicit(&a->segments[segment + 1], memory_order_relaxed) == NULL)
+    {
+        _carray_install(a, segment + 1);
+    }
+
+    data[offset] = stuff;
+    // With no producer behind it the slot is committed straight away and its flag
+    // is never read, otherwise it is left for whoever closes the gap
+    long expected = index;
+    if (!atomic_compare_exchange_strong(&a->committed, &expected, index + 1))
+    {
+        atomic_store(&_carray_ready(data, segment)[offset], 1);
+        _carray_commit(a);
+    }
+    else if (atomic_load(&a->back) > index + 1)
+    {
+        _carray_commit(a);
+    }
+    return index;
+}
+
+// Primitives
+long carray_get(ConcurrentArray *a, long index)
+{
+    int segment = segment_index(index, CARRAY_LOG_FIRST);
+    assert(index >= 0 && index < atomic_load_explicit(&a->back, memory_order_relaxed));
+    long *data = atomic_load_explicit(&a->segments[segment], memory_order_acquire);
+    return data[index - segment_start(segment, CARRAY_LOG_FIRST)];
+}
+
+long carray_length(ConcurrentArray *a)
+{
+    return atomic_load_explicit(&a->committed, memory_order_acquire);
+}
+
+// Iteration
+void carray_foreach(ConcurrentArray *a, void fn(long))
+{
+    long length = carray_length(a);
+    for (int segment = 0; segment_start(segment, CARRAY_LOG_FIRST) < length; segment++)
+    {
+        long *data = atomic_load_explicit(&a->segments[segment], memory_order_acquire);
+        long start = segment_start(segment, CARRAY_LOG_FIRST);
+        long end = start + segment_length(segment, CARRAY_LOG_FIRST);
+        end = end < length ? end : length;
+        for (long i = start; i < end; i++)
+        {
+            fn(data[i - start]);
+        }
+    }
+}
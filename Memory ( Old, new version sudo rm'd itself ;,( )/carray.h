@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdatomic.h>
+
+// Append-only array for several producer threads. insertBack takes a slot with
+// one atomic fetch-add on back, and storage grows in segments that never move:
+// segment k holds CARRAY_FIRST << k elements, so an index maps to its segment
+// with a bit scan and readers never wait for, or race with, a growth.
+//
+// An element can be read once its insertBack has returned, as seen through the
+// caller's own synchronisation (joining the producer, a queue, ...). Every index
+// below carray_length can be read at any time: the length only covers a prefix
+// of slots that have all been written, so a slow producer holds it back rather
+// than leaving a hole in it.
+
+#define CARRAY_LOG_FIRST 10
+#define CARRAY_FIRST (1L << CARRAY_LOG_FIRST)
+#define CARRAY_SEGMENTS 48
+
+typedef struct ConcurrentArray ConcurrentArray;
+struct ConcurrentArray {
+    atomic_long back;      // Next slot to hand out
+    atomic_long committed; // Every slot below it has been written
+    long* _Atomic segments[CARRAY_SEGMENTS];
+};
+
+// Construction / Destruction, not thread safe
+void carray_init(ConcurrentArray* a);
+void carray_destroy(ConcurrentArray* a);
+
+// Returns the index the element was stored at
+long carray_insertBack(ConcurrentArray* a, long stuff);
+
+long carray_get(ConcurrentArray* a, long index);
+long carray_length(ConcurrentArray* a);
+void carray_foreach(ConcurrentArray* a, void fn(long));
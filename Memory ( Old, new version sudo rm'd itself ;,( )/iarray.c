@@ -0,0 +1,101 @@
+#include <assert.h>
+#include <stddef.h>
+
+#include "iarray.h"
+
+// Construction / Destruction
+void iarray_init(InlineArray *a)
+{
+    iarray_initWith(a, allocator_system());
+}
+
+// Like array_newWith, the allocator must outlive the array. It is only used once
+// the elements spill out of the struct.
+void iarray_initWith(InlineArray *a, Allocator *allocator)
+{
+    a->length = 0;
+    a->allocator = allocator;
+    a->spilled.data = NULL;
+}
+
+void iarray_destroy(InlineArray *a)
+{
+    if (a->spilled.data != NULL)
+    {
+        array_destroy(a->spilled);
+        a->spilled.data = NULL;
+    }
+    a->length = 0;
+}
+
+// Primitives
+long iarray_get(InlineArray *a, long index)
+{
+    if (a->spilled.data != NULL)
+    {
+        return array_get(a->spilled, index);
+    }
+    assert(index >= 0 && index < a->length);
+    return a->small[index];
+}
+
+long iarray_length(InlineArray *a)
+{
+    return a->spilled.data != NULL ? array_length(a->spilled) : a->length;
+}
+
+// Once spilled the array stays on the heap, even when popped back under IARRAY_CAPACITY
+void iarray_popBack(InlineArray *a)
+{
+    if (a->spilled.data != NULL)
+    {
+        array_popBack(&a->spilled);
+        return;
+    }
+    assert(a->length > 0);
+    a->length--;
+}
+
+// Iteration
+void iarray_foreach(InlineArray *a, void fn(long))
+{
+    if (a->spilled.data != NULL)
+    {
+        array_foreach(a->spilled, fn);
+        return;
+    }
+    for (long i = 0; i < a->length; i++)
+    {
+        fn(a->small[i]);
+    }
+}
+
+long iarray_sum(InlineArray *a)
+{
+    if (a->spilled.data != NULL)
+    {
+        return array_sum(a->spilled);
+    }
+    long sum = 0;
+    for (long i = 0; i < a->length; i++)
+    {
+        sum += a->small[i];
+    }
+    return sum;
+}
+
+// Modifiers
+void iarray_insertBack(InlineArray *a, long stuff)
+{
+    if (a->spilled.data == NULL && a->length < IARRAY_CAPACITY)
+    {
+        a->small[a->length++] = stuff;
+        return;
+    }
+    if (a->spilled.data == NULL)
+    {
+        a->spilled = array_newWith(2 * IARRAY_CAPACITY, a->allocator);
+        array_insertBackN(&a->spilled, a->small, a->length);
+    }
+    array_insertBack(&a->spilled, stuff);
+}
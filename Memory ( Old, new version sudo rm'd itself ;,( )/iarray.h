@@ -0,0 +1,38 @@
+#pragma once
+
+#include "array.h"
+
+// Array for the many that never hold more than a few elements: the first
+// IARRAY_CAPACITY live in the struct itself, so creating, filling and destroying
+// one allocates nothing. The insert past that moves them all to an Array, which
+// holds every element from then on. Elements can not be inline in Array itself,
+// it is passed by value and would point into whichever copy it was made from.
+
+#ifndef IARRAY_CAPACITY
+#define IARRAY_CAPACITY 8
+#endif
+
+typedef struct InlineArray InlineArray;
+struct InlineArray {
+    long length; // Elements in small[], unused once spilled
+    long small[IARRAY_CAPACITY];
+    Allocator* allocator;
+    Array spilled; // data is NULL until the elements no longer fit in small[]
+};
+
+// Construction / Destruction
+void iarray_init(InlineArray* a);
+void iarray_initWith(InlineArray* a, Allocator* allocator);
+void iarray_destroy(InlineArray* a);
+
+// Primitives
+long iarray_get(InlineArray* a, long index);
+long iarray_length(InlineArray* a);
+void iarray_popBack(InlineArray* a);
+
+// Iteration
+void iarray_foreach(InlineArray* a, void fn(long));
+long iarray_sum(InlineArray* a);
+
+// Modifiers
+void iarray_insertBack(InlineArray* a, long stuff);
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+
+#include "allocator.h"
+#include "matrix.h"
+
+// The block comes from a RealtimeAllocator, which maps it rather than malloc'ing it:
+// it is large, page aligned, and the kernel only commits the pages that are actually
+// touched, as in Task A. The matrix flags pick the allocator flags.
+static void _matrix_allocator(RealtimeAllocator *realtime, unsigned flags)
+{
+    unsigned realtimeFlags = 0;
+    realtimeFlags |= flags & MATRIX_HUGETLB ? ALLOCATOR_HUGETLB : flags & MATRIX_HUGEPAGES ? ALLOCATOR_HUGEPAGES : 0;
+    realtimeFlags |= flags & MATRIX_PREFAULT ? ALLOCATOR_PREFAULT : 0;
+    realtimeFlags |= flags & MATRIX_LOCK ? ALLOCATOR_LOCK : 0;
+    realtimeFlags |= flags & MATRIX_INTERLEAVE ? ALLOCATOR_INTERLEAVE : 0;
+    realtime_init(realtime, realtimeFlags);
+}
+
+Matrix matrix_new(long x_dim, long y_dim, unsigned flags)
+{
+    Matrix m = {NULL, NULL, x_dim, y_dim, sizeof(long) * x_dim * y_dim, flags & ~MATRIX_HUGETLB};
+    if (x_dim <= 0 || y_dim <= 0)
+    {
+        return m;
+    }
+
+    // Explicit hugepages when some are reserved (vm.nr_hugepages), transparent ones otherwise
+    RealtimeAllocator realtime;
+    if (m.flags & MATRIX_HUGEPAGES)
+    {
+        _matrix_allocator(&realtime, m.flags | MATRIX_HUGETLB);
+        m.data = realtime.base.allocate(&realtime.base, m.bytes);
+        m.flags |= m.data != NULL ? MATRIX_HUGETLB : 0;
+    }
+    if (m.data == NULL)
+    {
+        _matrix_allocator(&realtime, m.flags);
+        m.data = realtime.base.allocate(&realtime.base, m.bytes);
+    }
+    if (m.data == NULL)
+    {
+        return m;
+    }
+    m.bytes = realtime.base.usable(&realtime.base, m.bytes);
+    if (realtime.placeFailures > 0)
+    {
+        m.flags &= ~MATRIX_INTERLEAVE;
+    }
+    if (realtime.lockFailures > 0)
+    {
+        m.flags &= ~MATRIX_LOCK;
+    }
+
+    if (m.flags & MATRIX_ROWS)
+    {
+        m.rows = malloc(sizeof(long *) * y_dim);
+        if (m.rows == NULL)
+        {
+            realtime.base.release(&realtime.base, m.data, m.bytes);
+            m.data = NULL;
+            return m;
+        }
+        for (long y = 0; y < y_dim; y++)
+        {
+            m.rows[y] = matrix_row(m, y);
+        }
+    }
+    return m;
+}
+
+void matrix_destroy(Matrix m)
+{
+    if (m.data != NULL)
+    {
+        RealtimeAllocator realtime;
+        _matrix_allocator(&realtime, m.flags);
+        realtime.base.release(&realtime.base, m.data, m.bytes);
+    }
+    free(m.rows);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+// Matrix flags
+#define MATRIX_ROWS 0x1      // Also build row pointers, so rows[y][x] works like the task_a layout
+#define MATRIX_HUGEPAGES 0x2 // Back the block with hugepages: explicit ones if reserved, transparent ones otherwise
+#define MATRIX_HUGETLB 0x4   // Set by matrix_new when explicit hugepages were actually used
+#define MATRIX_PREFAULT 0x8  // Commit every page in matrix_new instead of on first access
+#define MATRIX_LOCK 0x10     // mlock the block, cleared by matrix_new if the lock was refused
+#define MATRIX_INTERLEAVE 0x20 // Spread the pages over all NUMA nodes, cleared if the kernel refused
+
+// A y_dim x x_dim matrix of longs in one contiguous block, row after row. Without
+// MATRIX_PREFAULT no page is touched by matrix_new, so workers that write their own
+// rows first get them on their own NUMA node. allocator_place(data, bytes,
+// ALLOCATOR_BIND, node) puts the whole block on one node instead.
+typedef struct Matrix Matrix;
+struct Matrix {
+    long* data;
+    long** rows; // Views into data, NULL unless MATRIX_ROWS
+    long x_dim;
+    long y_dim;
+    size_t bytes; // Size of the mapping behind data
+    unsigned flags;
+};
+
+// Like malloc, data is NULL when the memory could not be had
+Matrix matrix_new(long x_dim, long y_dim, unsigned flags);
+void matrix_destroy(Matrix m);
+
+static inline long* matrix_row(Matrix m, long y)
+{
+    return m.data + y * m.x_dim;
+}
+
+#define MATRIX_AT(m, x, y) ((m).data[(y) * (m).x_dim + (x)])
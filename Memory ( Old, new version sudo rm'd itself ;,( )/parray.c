@@ -0,0 +1,276 @@
+#include <assert.h>
+#include <string.h>
+
+#include "parray.h"
+
+// Elements per lane in a block. A lane of n bit elements is exactly n words.
+#define PARRAY_ROWS (PARRAY_BLOCK / PARRAY_LANES)
+
+// Packing
+static int _parray_bits(unsigned long x)
+{
+    return x == 0 ? 0 : 64 - __builtin_clzl(x);
+}
+
+// Element i goes to lane i % PARRAY_LANES, row i / PARRAY_LANES. Row j of a lane
+// starts at bit j * bits of the lane, and word w of lane l is words[w * PARRAY_LANES + l].
+static void _parray_pack(const unsigned long *values, int bits, unsigned long *words)
+{
+    memset(words, 0, sizeof(unsigned long) * PARRAY_LANES * bits);
+    for (int j = 0; j < PARRAY_ROWS && bits > 0; j++)
+    {
+        int p = j * bits, w = p >> 6, s = p & 63;
+        for (int l = 0; l < PARRAY_LANES; l++)
+        {
+            unsigned long v = values[j * PARRAY_LANES + l];
+            words[w * PARRAY_LANES + l] |= v << s;
+            if (s + bits > 64)
+            {
+                words[(w + 1) * PARRAY_LANES + l] |= v >> (64 - s);
+            }
+        }
+    }
+}
+
+static unsigned long _parray_unpackOne(const unsigned long *words, int bits, long k)
+{
+    if (bits == 0)
+    {
+        return 0;
+    }
+    int j = k / PARRAY_LANES, l = k % PARRAY_LANES;
+    int p = j * bits, w = p >> 6, s = p & 63;
+    unsigned long v = words[w * PARRAY_LANES + l] >> s;
+    if (s + bits > 64)
+    {
+        v |= words[(w + 1) * PARRAY_LANES + l] << (64 - s);
+    }
+    return bits == 64 ? v : v & ((1UL << bits) - 1);
+}
+
+// The stored value of element i in a delta block: the difference to the element
+// PARRAY_LANES before it, in the same lane, less the step. The first row has
+// nothing before it and takes the difference to reference. Wrapping unsigned
+// arithmetic, decoding undoes it exactly whatever the values are.
+static unsigned long _parray_delta(const unsigned long *x, int i, unsigned long reference, unsigned long step)
+{
+    return i < PARRAY_LANES ? x[i] - reference : x[i] - x[i - PARRAY_LANES] - step;
+}
+
+// Pack the full tail as one block, in whichever encoding needs fewer bits
+static void _parray_packTail(PackedArray *a)
+{
+    unsigned long *x = (unsigned long *)a->tail;
+    unsigned long values[PARRAY_BLOCK];
+
+    // Compared as signed, so the differences of sorted data are small and positive
+    long min = a->tail[0], firstRow = a->tail[0];
+    unsigned long step = x[PARRAY_LANES] - x[0];
+    for (int i = 1; i < PARRAY_BLOCK; i++)
+    {
+        min = a->tail[i] < min ? a->tail[i] : min;
+        firstRow = i < PARRAY_LANES && a->tail[i] < firstRow ? a->tail[i] : firstRow;
+        if (i >= PARRAY_LANES)
+        {
+            unsigned long d = x[i] - x[i - PARRAY_LANES];
+            step = (long)d < (long)step ? d : step;
+        }
+    }
+    unsigned long forRange = 0, deltaRange = 0;
+    for (int i = 0; i < PARRAY_BLOCK; i++)
+    {
+        forRange |= x[i] - (unsigned long)min;
+        deltaRange |= _parray_delta(x, i, (unsigned long)firstRow, step);
+    }
+
+    PackedBlock block = {.offset = a->words.back};
+    block.delta = _parray_bits(deltaRange) < _parray_bits(forRange);
+    block.bits = _parray_bits(block.delta ? deltaRange : forRange);
+    block.reference = block.delta ? (unsigned long)firstRow : (unsigned long)min;
+    block.step = block.delta ? step : 0;
+    for (int i = 0; i < PARRAY_BLOCK; i++)
+    {
+        values[i] = block.delta ? _parray_delta(x, i, block.reference, step) : x[i] - block.reference;
+    }
+
+    long words = PARRAY_LANES * block.bits;
+    while (a->words.back + words > a->words.capacity)
+    {
+        PackedWords_grow(&a->words);
+    }
+    _parray_pack(values, block.bits, a->words.data + a->words.back);
+    a->words.back += words;
+    PackedBlocks_insertBack(&a->blocks, block);
+    a->tailLength = 0;
+}
+
+// Decoding
+// PARRAY_LANES elements at a time with GCC vector extensions, which become
+// SSE/AVX on x86 and NEON on the Raspberry Pi, as in array.c
+#if defined(__GNUC__)
+typedef unsigned long PackedVector __attribute__((vector_size(PARRAY_LANES * sizeof(long))));
+
+// Vectors of 32 bytes are only passed through pointers and kept inside one
+// function: without AVX, passing them by value would not match the psABI
+static const PackedVector _parray_zero;
+
+static void _parray_decodeBlock(const PackedBlock *block, const unsigned long *words, long *out)
+{
+    int bits = block->bits;
+    PackedVector mask = _parray_zero + (bits == 64 ? ~0UL : (1UL << bits) - 1);
+    PackedVector reference = _parray_zero + block->reference;
+    PackedVector step = _parray_zero + block->step;
+    // The previous row of every lane, one step short of reference before the first
+    PackedVector carry = _parray_zero + (block->reference - block->step);
+
+    for (int j = 0; j < PARRAY_ROWS; j++)
+    {
+        PackedVector v = _parray_zero;
+        if (bits > 0)
+        {
+            int p = j * bits, w = p >> 6, s = p & 63;
+            PackedVector next;
+            memcpy(&v, words + w * PARRAY_LANES, sizeof(v));
+            v >>= s;
+            if (s + bits > 64)
+            {
+                memcpy(&next, words + (w + 1) * PARRAY_LANES, sizeof(next));
+                v |= next << (64 - s);
+            }
+            v &= mask;
+        }
+
+        if (block->delta)
+        {
+            // Every lane is its own running sum, nothing crosses lanes
+            v += carry + step;
+            carry = v;
+        }
+        else
+        {
+            v += reference;
+        }
+        memcpy(out + j * PARRAY_LANES, &v, sizeof(v));
+    }
+}
+#else
+static void _parray_decodeBlock(const PackedBlock *block, const unsigned long *words, long *out)
+{
+    for (long k = 0; k < PARRAY_BLOCK; k++)
+    {
+        unsigned long v = _parray_unpackOne(words, block->bits, k);
+        unsigned long previous = k < PARRAY_LANES ? block->reference - block->step : (unsigned long)out[k - PARRAY_LANES];
+        out[k] = (long)(block->delta ? previous + block->step + v : block->reference + v);
+    }
+}
+#endif
+
+// Construction / Destruction
+void parray_init(PackedArray *a)
+{
+    a->blocks = PackedBlocks_new(16);
+    a->words = PackedWords_new(16 * PARRAY_LANES);
+    a->tailLength = 0;
+}
+
+void parray_destroy(PackedArray *a)
+{
+    PackedBlocks_destroy(a->blocks);
+    PackedWords_destroy(a->words);
+}
+
+// Primitives
+long parray_length(PackedArray *a)
+{
+    return PackedBlocks_length(a->blocks) * PARRAY_BLOCK + a->tailLength;
+}
+
+size_t parray_bytes(PackedArray *a)
+{
+    return sizeof(PackedBlock) * PackedBlocks_length(a->blocks) + sizeof(unsigned long) * PackedWords_length(a->words) +
+           sizeof(long) * a->tailLength;
+}
+
+// A frame of reference element is read on its own, a delta one sums its lane up to it
+long parray_get(PackedArray *a, long index)
+{
+    assert(index >= 0 && index < parray_length(a));
+    long b = index / PARRAY_BLOCK;
+    long k = index % PARRAY_BLOCK;
+    if (b == PackedBlocks_length(a->blocks))
+    {
+        return a->tail[k];
+    }
+    PackedBlock *block = &a->blocks.data[b];
+    const unsigned long *words = a->words.data + block->offset;
+    if (!block->delta)
+    {
+        return (long)(block->reference + _parray_unpackOne(words, block->bits, k));
+    }
+    unsigned long x = block->reference - block->step;
+    for (long i = k % PARRAY_LANES; i <= k; i += PARRAY_LANES)
+    {
+        x += block->step + _parray_unpackOne(words, block->bits, i);
+    }
+    return (long)x;
+}
+
+long parray_decode(PackedArray *a, long block, long *out)
+{
+    assert(block >= 0 && block <= PackedBlocks_length(a->blocks));
+    if (block == PackedBlocks_length(a->blocks))
+    {
+        memcpy(out, a->tail, sizeof(long) * a->tailLength);
+        return a->tailLength;
+    }
+    _parray_decodeBlock(&a->blocks.data[block], a->words.data + a->blocks.data[block].offset, out);
+    return PARRAY_BLOCK;
+}
+
+// Iteration
+// Blocks are decoded one at a time into a buffer that stays in L1
+long parray_sum(PackedArray *a)
+{
+    long out[PARRAY_BLOCK];
+    unsigned long sum = 0;
+    for (long b = 0; b <= PackedBlocks_length(a->blocks); b++)
+    {
+        long n = parray_decode(a, b, out);
+        for (long i = 0; i < n; i++)
+        {
+            sum += out[i];
+        }
+    }
+    return (long)sum;
+}
+
+void parray_foreach(PackedArray *a, void fn(long))
+{
+    long out[PARRAY_BLOCK];
+    for (long b = 0; b <= PackedBlocks_length(a->blocks); b++)
+    {
+        long n = parray_decode(a, b, out);
+        for (long i = 0; i < n; i++)
+        {
+            fn(out[i]);
+        }
+    }
+}
+
+// Modifiers
+void parray_insertBack(PackedArray *a, long stuff)
+{
+    a->tail[a->tailLength++] = stuff;
+    if (a->tailLength == PARRAY_BLOCK)
+    {
+        _parray_packTail(a);
+    }
+}
+
+void parray_appendArray(PackedArray *a, Array b)
+{
+    ARRAY_FOREACH(x, b)
+    {
+        parray_insertBack(a, x);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "array.h"
+#include "array_template.h"
+
+// Read-mostly array of longs, compressed in blocks of PARRAY_BLOCK elements. Each
+// block is stored either as frame of reference (its minimum, then every element
+// less that minimum) or as deltas (a reference and the smallest step, then every
+// difference less that step), whichever needs fewer bits per element. Small values
+// and sorted timestamps take a few bits each.
+//
+// The bits of a block are in PARRAY_LANES interleaved lanes, element i in lane
+// i % PARRAY_LANES, so decoding unpacks PARRAY_LANES elements per vector operation.
+// Deltas are taken within a lane, to the element PARRAY_LANES back, so undoing
+// them is plain vector adds as well. Elements are appended to an uncompressed
+// tail that is packed whenever it fills a block.
+
+#define PARRAY_BLOCK 256
+#define PARRAY_LANES 4
+
+typedef struct PackedBlock PackedBlock;
+struct PackedBlock {
+    unsigned long reference; // Minimum, of the first row for deltas
+    unsigned long step;      // Smallest difference within a lane, for deltas
+    long offset;             // Where the block's words start
+    unsigned char bits;      // Per element, 0 to 64. The block has PARRAY_LANES * bits words.
+    unsigned char delta;
+};
+
+ARRAY_DEFINE(PackedBlocks, PackedBlock)
+ARRAY_DEFINE(PackedWords, unsigned long)
+
+typedef struct PackedArray PackedArray;
+struct PackedArray {
+    PackedBlocks blocks;
+    PackedWords words;
+    long tail[PARRAY_BLOCK];
+    long tailLength;
+};
+
+// Construction / Destruction
+void parray_init(PackedArray* a);
+void parray_destroy(PackedArray* a);
+
+// Primitives
+long parray_length(PackedArray* a);
+size_t parray_bytes(PackedArray* a); // Memory the elements take, to compare with sizeof(long) * length
+long parray_get(PackedArray* a, long index);
+// Block level random access: the elements of block `block` into out, returns how many
+long parray_decode(PackedArray* a, long block, long* out);
+
+// Iteration
+long parray_sum(PackedArray* a);
+void parray_foreach(PackedArray* a, void fn(long));
+
+// Modifiers
+void parray_insertBack(PackedArray* a, long stuff);
+void parray_appendArray(PackedArray* a, Array b);
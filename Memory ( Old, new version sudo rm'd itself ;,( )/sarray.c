@@ -0,0 +1,114 @@
+#include <assert.h>
+#include <stddef.h>
+
+#include "sarray.h"
+#include "segments.h"
+
+// Chunks
+// Chunk k is segment k of segments.h
+static size_t _sarray_chunkBytes(int chunk)
+{
+    return sizeof(long) * segment_length(chunk, SARRAY_LOG_FIRST);
+}
+
+// Construction / Destruction
+void sarray_init(SegmentedArray *a)
+{
+    sarray_initWith(a, allocator_system());
+}
+
+// Like array_newWith, the allocator must outlive the array
+void sarray_initWith(SegmentedArray *a, Allocator *allocator)
+{
+    a->back = 0;
+    a->chunks = 0;
+    a->allocator = allocator;
+    for (int c = 0; c < SARRAY_CHUNKS; c++)
+    {
+        a->chunk[c] = NULL;
+    }
+}
+
+void sarray_destroy(SegmentedArray *a)
+{
+    a->back = 0;
+    sarray_shrinkToFit(a);
+}
+
+// Primitives
+long sarray_get(SegmentedArray *a, long index)
+{
+    return *sarray_at(a, index);
+}
+
+long *sarray_at(SegmentedArray *a, long index)
+{
+    assert(index >= 0 && index < a->back);
+    int chunk = segment_index(index, SARRAY_LOG_FIRST);
+    return a->chunk[chunk] + (index - segment_start(chunk, SARRAY_LOG_FIRST));
+}
+
+long sarray_length(SegmentedArray *a)
+{
+    return a->back;
+}
+
+// Chunks are kept for the next inserts, sarray_shrinkToFit gives them back
+void sarray_popBack(SegmentedArray *a)
+{
+    assert(a->back > 0);
+    a->back--;
+}
+
+// Iteration
+void sarray_foreach(SegmentedArray *a, void fn(long))
+{
+    for (int chunk = 0; segment_start(chunk, SARRAY_LOG_FIRST) < a->back; chunk++)
+    {
+        long *data = a->chunk[chunk];
+        long start = segment_start(chunk, SARRAY_LOG_FIRST);
+        long end = start + segment_length(chunk, SARRAY_LOG_FIRST);
+        end = end < a->back ? end : a->back;
+        for (long i = start; i < end; i++)
+        {
+            fn(data[i - start]);
+        }
+    }
+}
+
+// Capacity
+// Allocate chunks up front, e.g. before a real-time loop, so no insert allocates
+void sarray_reserve(SegmentedArray *a, long capacity)
+{
+    while (segment_start(a->chunks, SARRAY_LOG_FIRST) < capacity)
+    {
+        assert(a->chunks < SARRAY_CHUNKS);
+        long *data = a->allocator->allocate(a->allocator, _sarray_chunkBytes(a->chunks));
+        assert(data != NULL);
+        a->chunk[a->chunks++] = data;
+    }
+}
+
+// Release the chunks past the one holding the last element
+void sarray_shrinkToFit(SegmentedArray *a)
+{
+    int used = a->back > 0 ? segment_index(a->back - 1, SARRAY_LOG_FIRST) + 1 : 0;
+    while (a->chunks > used)
+    {
+        a->chunks--;
+        a->allocator->release(a->allocator, a->chunk[a->chunks], _sarray_chunkBytes(a->chunks));
+        a->chunk[a->chunks] = NULL;
+    }
+}
+
+// Modifiers
+void sarray_insertBack(SegmentedArray *a, long stuff)
+{
+    // Past the last chunk, allocate the next one. Nothing already there moves.
+    if (a->back == segment_start(a->chunks, SARRAY_LOG_FIRST))
+    {
+        sarray_reserve(a, a->back + 1);
+    }
+    a->back++;
+    *sarray_at(a, a->back - 1) = stuff;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "allocator.h"
+
+// Array whose storage is a directory of chunks: chunk k holds SARRAY_FIRST << k
+// elements, so an index maps to its chunk with a bit scan. Growing allocates the
+// next chunk and never moves or copies what is there, so pointers from sarray_at
+// stay valid until the element is popped or the array destroyed.
+
+#define SARRAY_LOG_FIRST 10
+#define SARRAY_FIRST (1L << SARRAY_LOG_FIRST)
+#define SARRAY_CHUNKS 48
+
+typedef struct SegmentedArray SegmentedArray;
+struct SegmentedArray {
+    long back;
+    int chunks; // Allocated, always the first ones
+    Allocator* allocator;
+    long* chunk[SARRAY_CHUNKS];
+};
+
+// Construction / Destruction
+void sarray_init(SegmentedArray* a);
+void sarray_initWith(SegmentedArray* a, Allocator* allocator);
+void sarray_destroy(SegmentedArray* a);
+
+// Primitives
+long sarray_get(SegmentedArray* a, long index);
+long* sarray_at(SegmentedArray* a, long index);
+long sarray_length(SegmentedArray* a);
+void sarray_popBack(SegmentedArray* a);
+
+// Iteration
+void sarray_foreach(SegmentedArray* a, void fn(long));
+
+// Capacity
+void sarray_reserve(SegmentedArray* a, long capacity);
+void sarray_shrinkToFit(SegmentedArray* a);
+
+// Modifiers
+void sarray_insertBack(SegmentedArray* a, long stuff);
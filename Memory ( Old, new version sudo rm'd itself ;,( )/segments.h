@@ -0,0 +1,21 @@
+#pragma once
+
+// Power-of-two segments, for arrays whose storage never moves (carray.c, sarray.c).
+// With first = 1 << logFirst, segment k holds first << k elements and starts at
+// index first * (2^k - 1), so for index i the segment is the highest set bit of
+// i / first + 1: a shift and a bit scan, no loop and no table.
+
+static inline int segment_index(long index, int logFirst)
+{
+    return 63 - __builtin_clzl((unsigned long)(index >> logFirst) + 1);
+}
+
+static inline long segment_start(int segment, int logFirst)
+{
+    return (1L << logFirst) * ((1L << segment) - 1);
+}
+
+static inline long segment_length(int segment, int logFirst)
+{
+    return (1L << logFirst) << segment;
+}
@@ -0,0 +1,326 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#endif
+#include "scheduling.h"
+#include "policies.h"
+
+// Microbenchmark of scheduling decisions. Drives the enqueue, pick and preempt
+// operations of every policy in policies.c directly, without task threads or the
+// timer, for several task counts and arrival patterns. Results go to stdout and
+// as CSV to the file given as the first argument (bench_results.csv by default).
+//
+// Instructions and cache misses come from perf_event_open when the kernel allows it
+// (see /proc/sys/kernel/perf_event_paranoid), otherwise those columns are left empty.
+//
+// A timed window covers one round of a single operation, only 8 operations for the
+// smallest task set, so the cost of an empty window (clock_gettime and the counter
+// ioctls) is measured first and taken off every window.
+
+#define OPS_PER_CASE 200000
+#define MIN_ROUNDS 3
+#define CALIBRATION_WINDOWS 10001
+
+enum operation
+{
+    ENQUEUE,
+    PICK,
+    PREEMPT,
+    OPERATION_COUNT
+};
+
+static const char *operationString[] = {"enqueue", "pick", "preempt"};
+
+enum arrivalPattern
+{
+    SIMULTANEOUS, // Everything arrives at time 0
+    UNIFORM,      // Spread evenly over 10 time units per task
+    BURSTY,       // Groups of 16 tasks sharing an arrival time
+    PATTERN_COUNT
+};
+
+static const char *patternString[] = {"simultaneous", "uniform", "bursty"};
+
+static const int taskCounts[] = {8, 64, 512, 4096};
+
+struct Counters
+{
+    int instructionsFd;
+    int cacheMissesFd;
+};
+
+struct Measurement
+{
+    double nanoseconds;
+    long long instructions;
+    long long cacheMisses;
+    long long ops;
+};
+
+static int open_counter(unsigned int type, unsigned long long config)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+static void counters_open(struct Counters *counters)
+{
+#ifdef __linux__
+    counters->instructionsFd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    counters->cacheMissesFd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#else
+    counters->instructionsFd = -1;
+    counters->cacheMissesFd = -1;
+#endif
+}
+
+static void counter_start(int fd)
+{
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+static long long counter_stop(int fd)
+{
+    long long value = 0;
+#ifdef __linux__
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &value, sizeof(value)) != sizeof(value))
+            value = 0;
+    }
+#endif
+    return value;
+}
+
+static double now_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void measure_start(struct Counters *counters, double *start)
+{
+    counter_start(counters->instructionsFd);
+    counter_start(counters->cacheMissesFd);
+    *start = now_ns();
+}
+
+// Cost of one empty window, taken off every measured one
+static struct Measurement overhead;
+
+static void measure_stop(struct Counters *counters, double start, struct Measurement *measurement, int ops)
+{
+    double end = now_ns();
+    measurement->instructions += counter_stop(counters->instructionsFd) - overhead.instructions;
+    measurement->cacheMisses += counter_stop(counters->cacheMissesFd) - overhead.cacheMisses;
+    measurement->nanoseconds += end - start - overhead.nanoseconds;
+    measurement->ops += ops;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// The median time of an empty window, so an interrupt in one of them does not count,
+// and the mean of the counters, which hardly vary
+static void calibrate(struct Counters *counters)
+{
+    static double times[CALIBRATION_WINDOWS];
+    struct Measurement empty = {0};
+    for (int i = 0; i < CALIBRATION_WINDOWS; i++)
+    {
+        double start;
+        measure_start(counters, &start);
+        measure_stop(counters, start, &empty, 0);
+        times[i] = empty.nanoseconds;
+        empty.nanoseconds = 0;
+    }
+    qsort(times, CALIBRATION_WINDOWS, sizeof(double), compare_double);
+    overhead.nanoseconds = times[CALIBRATION_WINDOWS / 2];
+    overhead.instructions = empty.instructions / CALIBRATION_WINDOWS;
+    overhead.cacheMisses = empty.cacheMisses / CALIBRATION_WINDOWS;
+}
+
+static unsigned long long rngState = 4147;
+
+static unsigned int bench_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (unsigned int)((rngState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static void make_tasks(struct Task *tasks, struct Task **taskPointers, int taskCount, enum arrivalPattern pattern)
+{
+    for (int i = 0; i < taskCount; i++)
+    {
+        tasks[i].state = idle;
+        tasks[i].ID = i;
+        tasks[i].totalRuntime = 1 + bench_random() % 1000;
+        tasks[i].startTime = -1;
+        tasks[i].currentRuntime = 0;
+
+        switch (pattern)
+        {
+        case SIMULTANEOUS:
+            tasks[i].arrivalTime = 0;
+            break;
+        case UNIFORM:
+            tasks[i].arrivalTime = bench_random() % (10 * taskCount);
+            break;
+        default:
+            tasks[i].arrivalTime = (bench_random() % (taskCount / 16 + 1)) * 160;
+            break;
+        }
+        taskPointers[i] = &tasks[i];
+    }
+}
+
+// One round fills a fresh ready structure, drains it with picks as the scheduler
+// would, lets every task run for a while and hands them back through preempt
+static void run_case(const struct Policy *policy, struct Task **tasks, int taskCount, int quantum,
+                     struct Counters *counters, struct Measurement *results)
+{
+    int *order = malloc(taskCount * sizeof(int));
+    int rounds = OPS_PER_CASE / taskCount;
+    if (rounds < MIN_ROUNDS)
+        rounds = MIN_ROUNDS;
+
+    int now = 0;
+    for (int i = 0; i < taskCount; i++)
+        if (tasks[i]->arrivalTime > now)
+            now = tasks[i]->arrivalTime;
+
+    for (int r = 0; r < rounds; r++, now += quantum)
+    {
+        struct ReadyQueue *queue = policy->create(tasks, taskCount, quantum);
+        double start;
+        int slice;
+
+        measure_start(counters, &start);
+        for (int i = 0; i < taskCount; i++)
+            policy->enqueue(queue, i, now);
+        measure_stop(counters, start, &results[ENQUEUE], taskCount);
+
+        measure_start(counters, &start);
+        for (int i = 0; i < taskCount; i++)
+            order[i] = policy->pick(queue, now, &slice);
+        measure_stop(counters, start, &results[PICK], taskCount);
+
+        // Advance the tasks so remaining-time policies see changing keys, wrapping before they finish
+        for (int i = 0; i < taskCount; i++)
+        {
+            struct Task *task = tasks[order[i]];
+            task->currentRuntime = (task->currentRuntime + quantum) % task->totalRuntime;
+        }
+
+        measure_start(counters, &start);
+        for (int i = 0; i < taskCount; i++)
+            policy->preempt(queue, order[i], now);
+        measure_stop(counters, start, &results[PREEMPT], taskCount);
+
+        policy->destroy(queue);
+    }
+
+    free(order);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outputName = argc > 1 ? argv[1] : "bench_results.csv";
+    FILE *output = fopen(outputName, "w");
+    if (output == NULL)
+    {
+        perror("Failed to open results file");
+        exit(EXIT_FAILURE);
+    }
+
+    struct Counters counters;
+    counters_open(&counters);
+    int haveCounters = counters.instructionsFd >= 0 && counters.cacheMissesFd >= 0;
+    if (!haveCounters)
+        printf("perf_event_open unavailable, reporting time only\n");
+    calibrate(&counters);
+    printf("Empty window: %.1f ns, %lld instructions, taken off every measurement\n", overhead.nanoseconds,
+           overhead.instructions);
+
+    int maxTasks = taskCounts[sizeof(taskCounts) / sizeof(taskCounts[0]) - 1];
+    struct Task *tasks = malloc(maxTasks * sizeof(struct Task));
+    struct Task **taskPointers = malloc(maxTasks * sizeof(struct Task *));
+
+    fprintf(output, "policy,tasks,arrivals,operation,ops,ns_per_op,instructions_per_op,cache_misses_per_op\n");
+    printf("%-5s %6s %-12s %-8s %10s %10s %10s\n", "", "tasks", "arrivals", "op", "ns/op", "instr/op", "miss/op");
+
+    for (SchedulerType type = FCFS; type <= FEED; type++)
+    {
+        for (size_t c = 0; c < sizeof(taskCounts) / sizeof(taskCounts[0]); c++)
+        {
+            for (enum arrivalPattern pattern = SIMULTANEOUS; pattern < PATTERN_COUNT; pattern++)
+            {
+                struct Measurement results[OPERATION_COUNT] = {0};
+
+                make_tasks(tasks, taskPointers, taskCounts[c], pattern);
+                run_case(&policies[type], taskPointers, taskCounts[c], QUANTUM, &counters, results);
+
+                for (enum operation op = ENQUEUE; op < OPERATION_COUNT; op++)
+                {
+                    struct Measurement *m = &results[op];
+                    double ns = m->nanoseconds / m->ops;
+
+                    fprintf(output, "%s,%d,%s,%s,%lld,%.2f", policies[type].name, taskCounts[c],
+                            patternString[pattern], operationString[op], m->ops, ns);
+                    printf("%-5s %6d %-12s %-8s %10.2f", policies[type].name, taskCounts[c],
+                           patternString[pattern], operationString[op], ns);
+
+                    if (haveCounters)
+                    {
+                        fprintf(output, ",%.2f,%.4f\n", (double)m->instructions / m->ops, (double)m->cacheMisses / m->ops);
+                        printf(" %10.2f %10.4f\n", (double)m->instructions / m->ops, (double)m->cacheMisses / m->ops);
+                    }
+                    else
+                    {
+                        fprintf(output, ",,\n");
+                        printf(" %10s %10s\n", "-", "-");
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Results written to %s\n", outputName);
+
+    free(tasks);
+    free(taskPointers);
+    fclose(output);
+    return 0;
+}
@@ -0,0 +1,261 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include "scheduling.h"
+#include "file_handling.h"
+#include "realtime.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "RTCK"
+#define CHECKPOINT_VERSION 1
+
+// All values are stored as little-endian 32-bit integers so a checkpoint taken on the
+// lab Raspberry Pi can be resumed on a PC and the other way around
+static void put_int(FILE *file, long long value)
+{
+    unsigned char bytes[4];
+    for (int i = 0; i < 4; i++)
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static int get_int(FILE *file, int *value)
+{
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes))
+        return -1;
+
+    unsigned int raw = 0;
+    for (int i = 0; i < 4; i++)
+        raw |= (unsigned int)bytes[i] << (8 * i);
+    *value = (int)raw;
+    return 0;
+}
+
+static void put_requests(FILE *file, struct AperiodicRequest *requests, int count)
+{
+    put_int(file, count);
+    for (int i = 0; i < count; i++)
+    {
+        put_int(file, requests[i].ID);
+        put_int(file, requests[i].arrivalTime);
+        put_int(file, requests[i].runtime);
+        put_int(file, requests[i].remaining);
+        put_int(file, requests[i].startTime);
+        put_int(file, requests[i].finishTime);
+    }
+}
+
+// Every stored request is six integers
+#define REQUEST_BYTES (6 * 4)
+
+// Bytes left between the file position and the end, so a corrupt count cannot
+// make the loader allocate more than the file could possibly describe
+static long bytes_left(FILE *file)
+{
+    long position = ftell(file);
+    if (position < 0 || fseek(file, 0, SEEK_END) != 0)
+        return 0;
+    long size = ftell(file);
+    fseek(file, position, SEEK_SET);
+    return size - position;
+}
+
+static int get_requests(FILE *file, struct AperiodicRequest **requests, int *count, int *capacity)
+{
+    if (get_int(file, count) || *count < 0 || *count > bytes_left(file) / REQUEST_BYTES)
+        return -1;
+
+    *capacity = *count > 0 ? *count : 1;
+    *requests = malloc(*capacity * sizeof(struct AperiodicRequest));
+    if (*requests == NULL)
+        return -1;
+
+    for (int i = 0; i < *count; i++)
+    {
+        struct AperiodicRequest *request = &(*requests)[i];
+        if (get_int(file, &request->ID) || get_int(file, &request->arrivalTime)
+            || get_int(file, &request->runtime) || get_int(file, &request->remaining)
+            || get_int(file, &request->startTime) || get_int(file, &request->finishTime)
+            || request->arrivalTime < 0 || request->runtime <= 0
+            || request->remaining < 0 || request->remaining > request->runtime
+            || (request->startTime != -1 && request->startTime < request->arrivalTime)
+            || (request->finishTime != -1 && request->finishTime < request->arrivalTime))
+            return -1;
+    }
+    return 0;
+}
+
+int rt_save_checkpoint(struct RtSimulation *sim, const char *filename)
+{
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL)
+        return -1;
+
+    fwrite(CHECKPOINT_MAGIC, 1, 4, file);
+    put_int(file, CHECKPOINT_VERSION);
+
+    put_int(file, sim->policy);
+    put_int(file, sim->now);
+    put_int(file, sim->horizon);
+    put_int(file, sim->running);
+
+    put_int(file, sim->periodicCount);
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        put_int(file, task->state);
+        put_int(file, task->ID);
+        put_int(file, task->period);
+        put_int(file, task->wcet);
+        put_int(file, task->deadline);
+        put_int(file, task->release);
+        put_int(file, task->remaining);
+        put_int(file, task->jobsReleased);
+        put_int(file, task->jobsCompleted);
+        put_int(file, task->deadlineMisses);
+    }
+
+    // Explicit requests that have already arrived live in requests, only the rest is needed
+    put_requests(file, sim->scheduled + sim->nextScheduled, sim->scheduledCount - sim->nextScheduled);
+    put_requests(file, sim->requests, sim->requestCount);
+    put_int(file, sim->queueHead);
+
+    struct Server *server = &sim->server;
+    put_int(file, server->type);
+    put_int(file, server->state);
+    put_int(file, server->period);
+    put_int(file, server->budget);
+    put_int(file, server->capacity);
+    put_int(file, server->periodStart);
+    put_int(file, server->activeSince);
+    put_int(file, server->consumed);
+    put_int(file, server->replenishmentCount);
+    for (int i = 0; i < server->replenishmentCount; i++)
+    {
+        put_int(file, server->replenishments[i].time);
+        put_int(file, server->replenishments[i].amount);
+    }
+
+    struct AperiodicSource *source = &sim->source;
+    put_int(file, source->nextID);
+    put_int(file, source->remainingCount);
+    put_int(file, source->meanInterarrival);
+    put_int(file, source->meanRuntime);
+    put_int(file, source->nextArrival);
+    put_int(file, source->nextRuntime);
+    put_int(file, source->rngState & 0xFFFFFFFFu);
+    put_int(file, source->rngState >> 32);
+
+    int failed = ferror(file);
+    if (fclose(file) != 0)
+        failed = 1;
+    return failed ? -1 : 0;
+}
+
+// The enums and indices are used to index tables and arrays, so a checkpoint that
+// does not hold together is refused with the first thing found wrong in it
+struct RtSimulation *rt_load_checkpoint(const char *filename)
+{
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL)
+        return NULL;
+
+    char magic[4];
+    int version = 0, value = 0;
+    const char *error = NULL;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, CHECKPOINT_MAGIC, 4) != 0)
+        error = "not a checkpoint";
+    else if (get_int(file, &version) || version != CHECKPOINT_VERSION)
+        error = "unsupported version";
+
+    struct RtSimulation *sim = calloc(1, sizeof(struct RtSimulation));
+
+    if (!error && (get_int(file, &value) || get_int(file, &sim->now) || get_int(file, &sim->horizon)
+                   || get_int(file, &sim->running) || get_int(file, &sim->periodicCount)))
+        error = "truncated header";
+    else if (!error && (value < FCFS || value > EDF))
+        error = "unknown policy";
+    else if (!error && sim->now < 0)
+        error = "negative time";
+    else if (!error && (sim->periodicCount < 0 || sim->periodicCount > bytes_left(file) / (10 * 4)))
+        error = "bad periodic task count";
+    else if (!error && (sim->running < -2 || sim->running >= sim->periodicCount))
+        error = "bad running task";
+    sim->policy = value;
+
+    if (!error)
+        sim->periodic = calloc(sim->periodicCount > 0 ? sim->periodicCount : 1, sizeof(struct PeriodicTask));
+    for (int i = 0; !error && i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        if (get_int(file, &value) || get_int(file, &task->ID) || get_int(file, &task->period)
+            || get_int(file, &task->wcet) || get_int(file, &task->deadline)
+            || get_int(file, &task->release) || get_int(file, &task->remaining)
+            || get_int(file, &task->jobsReleased) || get_int(file, &task->jobsCompleted)
+            || get_int(file, &task->deadlineMisses))
+            error = "truncated periodic task";
+        else if (value < idle || value > finished)
+            error = "bad periodic task state";
+        else if (task->period <= 0 || task->wcet <= 0 || task->deadline <= 0 || task->deadline > task->period)
+            error = "bad periodic task timing";
+        task->state = value;
+    }
+
+    if (!error && (get_requests(file, &sim->scheduled, &sim->scheduledCount, &sim->scheduledCapacity)
+                   || get_requests(file, &sim->requests, &sim->requestCount, &sim->requestCapacity)))
+        error = "bad aperiodic requests";
+    else if (!error && (get_int(file, &sim->queueHead) || sim->queueHead < 0 || sim->queueHead > sim->requestCount))
+        error = "bad queue head";
+    // Requests that have arrived cannot have done anything after the checkpoint was taken
+    for (int i = 0; !error && i < sim->requestCount; i++)
+        if (sim->requests[i].arrivalTime > sim->now || sim->requests[i].startTime > sim->now
+            || sim->requests[i].finishTime > sim->now)
+            error = "aperiodic request from the future";
+
+    struct Server *server = &sim->server;
+    int type = 0, state = 0;
+    if (!error && (get_int(file, &type) || get_int(file, &state)
+                   || get_int(file, &server->period) || get_int(file, &server->budget)
+                   || get_int(file, &server->capacity) || get_int(file, &server->periodStart)
+                   || get_int(file, &server->activeSince) || get_int(file, &server->consumed)
+                   || get_int(file, &server->replenishmentCount)))
+        error = "truncated server";
+    else if (!error && (type < BACKGROUND || type > SPORADIC || state < idle || state > finished))
+        error = "bad server type or state";
+    else if (!error && type != BACKGROUND && (server->period <= 0 || server->budget <= 0 || server->budget > server->period))
+        error = "bad server period or budget";
+    else if (!error && (server->replenishmentCount < 0 || server->replenishmentCount > MAX_REPLENISHMENTS))
+        error = "bad replenishment count";
+    server->type = type;
+    server->state = state;
+    for (int i = 0; !error && i < server->replenishmentCount; i++)
+        if (get_int(file, &server->replenishments[i].time) || get_int(file, &server->replenishments[i].amount))
+            error = "truncated replenishments";
+
+    struct AperiodicSource *source = &sim->source;
+    int rngLow = 0, rngHigh = 0;
+    if (!error && (get_int(file, &source->nextID) || get_int(file, &source->remainingCount)
+                   || get_int(file, &source->meanInterarrival) || get_int(file, &source->meanRuntime)
+                   || get_int(file, &source->nextArrival) || get_int(file, &source->nextRuntime)
+                   || get_int(file, &rngLow) || get_int(file, &rngHigh)))
+        error = "truncated request source";
+    source->rngState = (unsigned long long)(unsigned int)rngHigh << 32 | (unsigned int)rngLow;
+    // Drawing divides by the means, and xorshift never leaves a zero state
+    if (!error && source->nextArrival >= 0
+        && (source->meanInterarrival <= 0 || source->meanRuntime <= 0
+            || source->meanRuntime > INT_MAX / 2 || source->rngState == 0))
+        error = "bad request source";
+
+    fclose(file);
+
+    if (error)
+    {
+        guarded_printf(stderr, "%s: %s\n", filename, error);
+        rt_free(sim);
+        return NULL;
+    }
+    return sim;
+}
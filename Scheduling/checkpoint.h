@@ -0,0 +1,6 @@
+#pragma once
+
+// Snapshot of a real-time simulation, enough to continue it bit for bit or to fork it
+// into branches that share the simulated prefix but use a different policy
+int rt_save_checkpoint(struct RtSimulation *sim, const char *filename);
+struct RtSimulation *rt_load_checkpoint(const char *filename);
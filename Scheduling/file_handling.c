@@ -1,10 +1,13 @@
 #include <stdio.h>
+#include <stdarg.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
 #include "scheduling.h"
+#include "realtime.h"
 
 static pthread_mutex_t printf_mutex = PTHREAD_MUTEX_INITIALIZER;
 
@@ -79,4 +82,111 @@ struct Task **read_tasks_from_file(char *filename, int *taskCount)
 
     fclose(file);
     return tasks;
-}
\ No newline at end of file
+}
+
+static enum serverType parse_server_type(const char *name)
+{
+    if (strcmp(name, "POLL") == 0)
+        return POLLING;
+    else if (strcmp(name, "DEFER") == 0)
+        return DEFERRABLE;
+    else if (strcmp(name, "SPOR") == 0)
+        return SPORADIC;
+    else if (strcmp(name, "NONE") == 0)
+        return BACKGROUND;
+
+    guarded_printf(stderr, "Unknown server type: %s\n", name);
+    exit(1);
+}
+
+// Read periodic tasks, aperiodic requests and the server from a real-time task file.
+// Every line starts with a letter saying what it describes:
+//   P <ID> <period> <wcet> [deadline]          periodic task, deadline in 1..period, defaults to the period
+//   A <ID> <arrival_time> <runtime>             aperiodic request
+//   R <first_ID> <count> <mean_interarrival> <mean_runtime> <seed>
+//                                               random Poisson stream of aperiodic requests
+//   S <NONE|POLL|DEFER|SPOR> <period> <budget>  aperiodic server
+struct RtSimulation *read_rt_tasks_from_file(char *filename)
+{
+    FILE *file;
+    char line[100];
+    char serverName[16];
+    int lineNumber = 0;
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        guarded_printf(stdout, "Error opening file.\n");
+        exit(1);
+    }
+
+    struct RtSimulation *sim = calloc(1, sizeof(struct RtSimulation));
+    sim->server.type = BACKGROUND;
+    sim->source.nextArrival = -1;
+
+    while (fgets(line, sizeof(line), file))
+    {
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n')
+        {
+            continue;
+        }
+
+        int parsed = 0;
+        switch (line[0])
+        {
+        case 'P':
+        {
+            struct PeriodicTask task = {0};
+            int fields = sscanf(line + 1, "%d %d %d %d", &task.ID, &task.period, &task.wcet, &task.deadline);
+            // A missing deadline stays 0 and rt_prepare makes it the period
+            parsed = fields >= 3 && task.period > 0 && task.wcet > 0
+                     && (fields == 3 || (task.deadline > 0 && task.deadline <= task.period));
+            if (parsed)
+            {
+                sim->periodic = realloc(sim->periodic, (sim->periodicCount + 1) * sizeof(struct PeriodicTask));
+                sim->periodic[sim->periodicCount++] = task;
+            }
+            break;
+        }
+        case 'A':
+        {
+            int id, arrival_time, runtime;
+            parsed = sscanf(line + 1, "%d %d %d", &id, &arrival_time, &runtime) == 3 && runtime > 0;
+            if (parsed)
+                rt_add_request(sim, id, arrival_time, runtime);
+            break;
+        }
+        case 'R':
+        {
+            struct AperiodicSource *source = &sim->source;
+            parsed = sscanf(line + 1, "%d %d %d %d %llu", &source->nextID, &source->remainingCount,
+                            &source->meanInterarrival, &source->meanRuntime, &source->rngState) == 5
+                     && source->meanInterarrival > 0 && source->meanRuntime > 0
+                     && source->meanRuntime <= INT_MAX / 2;
+            // xorshift must never be seeded with zero
+            if (source->rngState == 0)
+                source->rngState = 1;
+            break;
+        }
+        case 'S':
+            parsed = sscanf(line + 1, "%15s %d %d", serverName, &sim->server.period, &sim->server.budget) == 3;
+            if (parsed)
+            {
+                sim->server.type = parse_server_type(serverName);
+                parsed = sim->server.type == BACKGROUND
+                         || (sim->server.period > 0 && sim->server.budget > 0 && sim->server.budget <= sim->server.period);
+            }
+            break;
+        }
+
+        if (!parsed)
+        {
+            guarded_printf(stderr, "%s:%d: malformed line: %s", filename, lineNumber, line);
+            exit(1);
+        }
+    }
+
+    fclose(file);
+    return sim;
+}
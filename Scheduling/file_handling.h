@@ -1,2 +1,3 @@
 void guarded_printf(FILE *output, const char *format, ...);
 struct Task **read_tasks_from_file(char *filename, int *taskCount);
+struct RtSimulation *read_rt_tasks_from_file(char *filename);
\ No newline at end of file
@@ -0,0 +1,491 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include "scheduling.h"
+#include "schedulers.h"
+#include "policies.h"
+
+// Differential fuzzer for the policies in policies.c.
+// Random workloads are run through each policy and through a reference model that
+// steps one time unit at a time and scans the whole task table like schedulers.c.
+// With --threaded the policies are instead checked against the threaded schedulers
+// in schedulers.c themselves, run with task threads on a clock that ticks in lockstep.
+// Any difference in the dispatch sequence is reported with the workload in tasks.txt format.
+//
+// Usage: ./fuzz [--threaded] [workloads] [seed]
+
+#define MAX_TASKS 24
+#define MAX_DISPATCHES 4096
+#define FUZZ_QUANTUM 4
+#define FUZZ_TIMEOUT 100000
+
+static unsigned long long rngState;
+
+// Defined by scheduling.c in the real program, schedulers.c waits on them
+volatile int globalTime = 0;
+pthread_cond_t timeCond = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t timeMutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t taskStateMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int fuzz_random(void)
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return (unsigned int)((rngState * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+// Reference model, a direct transcription of the scheduling decisions in schedulers.c into virtual time
+static int reference_pick(SchedulerType type, struct Task *tasks, int taskCount, int now, int *queue, int *rrIndex)
+{
+    int priorityId = -1;
+
+    if (type == RR)
+    {
+        for (int n = 0; n < taskCount; n++)
+        {
+            int i = (*rrIndex + n) % taskCount;
+            if (tasks[i].state != finished && tasks[i].arrivalTime <= now)
+            {
+                *rrIndex = (i + 1) % taskCount;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int bestInt = 100000000;
+    double bestRatio = -1.0;
+    int bestQueue = FEED == type ? 2 : 0;
+
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (tasks[i].state == finished || tasks[i].arrivalTime > now)
+            continue;
+
+        switch (type)
+        {
+        case FCFS:
+            if (tasks[i].arrivalTime < bestInt)
+            {
+                bestInt = tasks[i].arrivalTime;
+                priorityId = i;
+            }
+            break;
+        case SPN:
+            if (tasks[i].totalRuntime < bestInt)
+            {
+                bestInt = tasks[i].totalRuntime;
+                priorityId = i;
+            }
+            break;
+        case HRRN:
+        {
+            double ratio = 1 + (double)(now - tasks[i].arrivalTime) / (double)tasks[i].totalRuntime;
+            if (ratio > bestRatio)
+            {
+                bestRatio = ratio;
+                priorityId = i;
+            }
+            break;
+        }
+        case SRT:
+            if (tasks[i].totalRuntime - tasks[i].currentRuntime < bestInt)
+            {
+                bestInt = tasks[i].totalRuntime - tasks[i].currentRuntime;
+                priorityId = i;
+            }
+            break;
+        case FEED:
+            if (queue[i] < bestQueue || (queue[i] == bestQueue && tasks[i].arrivalTime < bestInt))
+            {
+                bestQueue = queue[i];
+                bestInt = tasks[i].arrivalTime;
+                priorityId = i;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return priorityId;
+}
+
+static int reference_slice(SchedulerType type, int level)
+{
+    switch (type)
+    {
+    case RR:
+    case SRT:
+        return FUZZ_QUANTUM;
+    case FEED:
+        return level == 0 ? FUZZ_QUANTUM : level == 1 ? 2 * FUZZ_QUANTUM : RUN_TO_COMPLETION;
+    default:
+        return RUN_TO_COMPLETION;
+    }
+}
+
+static int reference_simulate(SchedulerType type, struct Task *workload, int taskCount, struct Dispatch *trace)
+{
+    struct Task tasks[MAX_TASKS];
+    int queue[MAX_TASKS] = {0};
+    int rrIndex = 0;
+    int running = -1;
+    int sliceLeft = 0;
+    int tasksFinished = 0;
+    int dispatches = 0;
+
+    memcpy(tasks, workload, taskCount * sizeof(struct Task));
+
+    for (int now = 0; tasksFinished < taskCount && now < FUZZ_TIMEOUT; now++)
+    {
+        if (running == -1)
+        {
+            running = reference_pick(type, tasks, taskCount, now, queue, &rrIndex);
+            if (running == -1)
+                continue;
+
+            if (dispatches < MAX_DISPATCHES)
+            {
+                trace[dispatches].time = now;
+                trace[dispatches].ID = tasks[running].ID;
+            }
+            dispatches++;
+            sliceLeft = reference_slice(type, queue[running]);
+        }
+
+        // Run one time unit
+        tasks[running].currentRuntime++;
+        if (tasks[running].currentRuntime == tasks[running].totalRuntime)
+        {
+            tasks[running].state = finished;
+            tasksFinished++;
+            running = -1;
+        }
+        else if (sliceLeft != RUN_TO_COMPLETION && --sliceLeft == 0)
+        {
+            if (queue[running] < 2)
+                queue[running]++;
+            running = -1;
+        }
+    }
+    return dispatches;
+}
+
+// Mix of shapes: bursts arriving together, ties on every key, and long idle gaps
+static int generate_workload(struct Task *tasks)
+{
+    int taskCount = 1 + fuzz_random() % MAX_TASKS;
+    int spread = 1 + fuzz_random() % 200;
+    int maxRuntime = 1 + fuzz_random() % 60;
+    int distinct = 1 + fuzz_random() % 8;
+
+    for (int i = 0; i < taskCount; i++)
+    {
+        tasks[i].state = idle;
+        tasks[i].ID = i;
+        tasks[i].arrivalTime = (fuzz_random() % distinct) * spread / distinct;
+        tasks[i].totalRuntime = 1 + fuzz_random() % maxRuntime;
+        tasks[i].startTime = -1;
+        tasks[i].currentRuntime = 0;
+    }
+    return taskCount;
+}
+
+// Lockstep clock
+// pthread_cond_wait is wrapped at link time (-Wl,--wrap=pthread_cond_wait). A wait on
+// timeCond parks the thread until the clock releases its side: on every tick the task
+// threads count the time unit first, then the scheduler reacts to it. The clock only
+// ticks once every thread is parked again, so a run does not depend on thread timing.
+int __real_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex);
+
+static pthread_mutex_t clockMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t clockCond = PTHREAD_COND_INITIALIZER;
+static int liveTasks, parkedTasks, schedulerParked, schedulerDone;
+static long taskTick, schedulerTick;
+static __thread int isScheduler;
+
+int __wrap_pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+{
+    if (cond != &timeCond)
+        return __real_pthread_cond_wait(cond, mutex);
+
+    pthread_mutex_unlock(mutex);
+    pthread_mutex_lock(&clockMutex);
+    long *tick = isScheduler ? &schedulerTick : &taskTick;
+    long seen = *tick;
+    if (isScheduler)
+        schedulerParked = 1;
+    else
+        parkedTasks++;
+    pthread_cond_broadcast(&clockCond);
+    while (*tick == seen)
+        __real_pthread_cond_wait(&clockCond, &clockMutex);
+    pthread_mutex_unlock(&clockMutex);
+    pthread_mutex_lock(mutex);
+    return 0;
+}
+
+// task_handler from scheduling.c without the logging
+static void *threaded_task(void *arg)
+{
+    struct Task *task = arg;
+    while (task->currentRuntime < task->totalRuntime)
+    {
+        pthread_mutex_lock(&timeMutex);
+        pthread_cond_wait(&timeCond, &timeMutex);
+        if (task->state == running)
+            task->currentRuntime++;
+        pthread_mutex_unlock(&timeMutex);
+    }
+    set_task_state(task, finished);
+
+    pthread_mutex_lock(&clockMutex);
+    liveTasks--;
+    pthread_cond_broadcast(&clockCond);
+    pthread_mutex_unlock(&clockMutex);
+    return NULL;
+}
+
+struct ThreadedRun
+{
+    SchedulerType type;
+    struct Task **tasks;
+    int taskCount;
+};
+
+static void *threaded_scheduler(void *arg)
+{
+    struct ThreadedRun *run = arg;
+    isScheduler = 1;
+    switch (run->type)
+    {
+    case FCFS:
+        first_come_first_served(run->tasks, run->taskCount, FUZZ_TIMEOUT);
+        break;
+    case SPN:
+        shortest_process_next(run->tasks, run->taskCount, FUZZ_TIMEOUT);
+        break;
+    case RR:
+        round_robin(run->tasks, run->taskCount, FUZZ_TIMEOUT, FUZZ_QUANTUM);
+        break;
+    case HRRN:
+        highest_response_ratio_next(run->tasks, run->taskCount, FUZZ_TIMEOUT);
+        break;
+    case SRT:
+        shortest_remaining_time(run->tasks, run->taskCount, FUZZ_TIMEOUT, FUZZ_QUANTUM);
+        break;
+    default:
+        feedback(run->tasks, run->taskCount, FUZZ_TIMEOUT, FUZZ_QUANTUM);
+        break;
+    }
+
+    pthread_mutex_lock(&clockMutex);
+    schedulerDone = 1;
+    pthread_cond_broadcast(&clockCond);
+    pthread_mutex_unlock(&clockMutex);
+    return NULL;
+}
+
+// Record the task that runs from now on, when it is not the one already running
+static int threaded_record(struct Task **tasks, int taskCount, struct Dispatch *trace, int dispatches, int *last)
+{
+    for (int i = 0; i < taskCount; i++)
+    {
+        if (tasks[i]->state == running && tasks[i]->ID != *last)
+        {
+            if (dispatches < MAX_DISPATCHES)
+                trace[dispatches] = (struct Dispatch){globalTime, tasks[i]->ID};
+            *last = tasks[i]->ID;
+            return dispatches + 1;
+        }
+    }
+    return dispatches;
+}
+
+// Runs the schedulers.c scheduler for type on the workload and returns its dispatches.
+// round_robin busy-waits while no task is ready, so workloads must never leave the CPU idle.
+static int threaded_simulate(SchedulerType type, struct Task *workload, int taskCount, struct Dispatch *trace)
+{
+    struct Task tasks[MAX_TASKS];
+    struct Task *taskPointers[MAX_TASKS];
+    pthread_t threads[MAX_TASKS];
+    pthread_t scheduler;
+    struct ThreadedRun run = {type, taskPointers, taskCount};
+    int dispatches = 0;
+    int last = -1;
+
+    memcpy(tasks, workload, taskCount * sizeof(struct Task));
+    globalTime = 0;
+    liveTasks = taskCount;
+    parkedTasks = schedulerParked = schedulerDone = 0;
+    for (int i = 0; i < taskCount; i++)
+    {
+        taskPointers[i] = &tasks[i];
+        pthread_create(&threads[i], NULL, threaded_task, &tasks[i]);
+    }
+    pthread_create(&scheduler, NULL, threaded_scheduler, &run);
+
+    pthread_mutex_lock(&clockMutex);
+    while (parkedTasks < liveTasks || !(schedulerParked || schedulerDone))
+        __real_pthread_cond_wait(&clockCond, &clockMutex);
+    dispatches = threaded_record(taskPointers, taskCount, trace, dispatches, &last);
+
+    while (liveTasks > 0 && !schedulerDone && globalTime < FUZZ_TIMEOUT)
+    {
+        pthread_mutex_lock(&timeMutex);
+        globalTime++;
+        pthread_mutex_unlock(&timeMutex);
+
+        parkedTasks = 0;
+        taskTick++;
+        pthread_cond_broadcast(&clockCond);
+        while (parkedTasks < liveTasks)
+            __real_pthread_cond_wait(&clockCond, &clockMutex);
+        if (liveTasks == 0)
+            break;
+
+        schedulerParked = 0;
+        schedulerTick++;
+        pthread_cond_broadcast(&clockCond);
+        while (!schedulerParked && !schedulerDone)
+            __real_pthread_cond_wait(&clockCond, &clockMutex);
+        dispatches = threaded_record(taskPointers, taskCount, trace, dispatches, &last);
+    }
+
+    // round_robin only returns at the timeout, and a task thread may still be parked
+    globalTime = FUZZ_TIMEOUT;
+    taskTick++;
+    schedulerTick++;
+    pthread_cond_broadcast(&clockCond);
+    pthread_mutex_unlock(&clockMutex);
+
+    pthread_join(scheduler, NULL);
+    for (int i = 0; i < taskCount; i++)
+        pthread_join(threads[i], NULL);
+    return dispatches;
+}
+
+// Pull arrivals in until every task arrives before the ones that arrived earlier have
+// finished, taken in arrival order, so there is always a task ready to run
+static void close_idle_gaps(struct Task *tasks, int taskCount)
+{
+    int order[MAX_TASKS];
+    for (int i = 0; i < taskCount; i++)
+    {
+        int j = i;
+        for (; j > 0 && tasks[order[j - 1]].arrivalTime > tasks[i].arrivalTime; j--)
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    int work = 0;
+    for (int i = 0; i < taskCount; i++)
+    {
+        struct Task *task = &tasks[order[i]];
+        if (task->arrivalTime > work)
+            task->arrivalTime = work;
+        work += task->totalRuntime;
+    }
+}
+
+// Merge back-to-back dispatches of the same task, the threaded run cannot see them
+static int merge_dispatches(struct Dispatch *trace, int count)
+{
+    int merged = 0;
+    for (int i = 0; i < count && i < MAX_DISPATCHES; i++)
+        if (merged == 0 || trace[merged - 1].ID != trace[i].ID)
+            trace[merged++] = trace[i];
+    return count > MAX_DISPATCHES ? count : merged;
+}
+
+static void print_divergence(const struct Policy *policy, int threaded, struct Task *workload, int taskCount,
+                             struct Dispatch *expected, int expectedCount, struct Dispatch *actual, int actualCount)
+{
+    int i = 0;
+    while (i < expectedCount && i < actualCount && i < MAX_DISPATCHES
+           && expected[i].time == actual[i].time && expected[i].ID == actual[i].ID)
+        i++;
+
+    printf("%s diverges from the %s at dispatch %d: ", policy->name, threaded ? "threaded scheduler" : "reference", i);
+    if (i < expectedCount && i < MAX_DISPATCHES)
+        printf("expected task %d at %d, ", expected[i].ID, expected[i].time);
+    else
+        printf("expected no more dispatches, ");
+    if (i < actualCount && i < MAX_DISPATCHES)
+        printf("got task %d at %d\n", actual[i].ID, actual[i].time);
+    else
+        printf("got no more dispatches\n");
+
+    printf("# ID arrival_time total_runtime\n");
+    for (int t = 0; t < taskCount; t++)
+        printf("%d %d %d\n", workload[t].ID, workload[t].arrivalTime, workload[t].totalRuntime);
+}
+
+int main(int argc, char *argv[])
+{
+    int threaded = argc > 1 && strcmp(argv[1], "--threaded") == 0;
+    argc -= threaded;
+    argv += threaded;
+    long workloads = argc > 1 ? atol(argv[1]) : threaded ? 200 : 100000;
+    rngState = argc > 2 ? strtoull(argv[2], NULL, 10) : (unsigned long long)time(NULL);
+    if (rngState == 0)
+        rngState = 1;
+    printf("Fuzzing %ld workloads%s, seed %llu\n", workloads, threaded ? " against the threaded schedulers" : "",
+           rngState);
+
+    struct Task workload[MAX_TASKS];
+    struct Task copy[MAX_TASKS];
+    struct Task *taskPointers[MAX_TASKS];
+    struct Dispatch expected[MAX_DISPATCHES];
+    struct Dispatch actual[MAX_DISPATCHES];
+    long divergences = 0;
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (long w = 0; w < workloads; w++)
+    {
+        int taskCount = generate_workload(workload);
+        if (threaded)
+            close_idle_gaps(workload, taskCount);
+
+        for (SchedulerType type = FCFS; type <= FEED; type++)
+        {
+            const struct Policy *policy = &policies[type];
+
+            memcpy(copy, workload, taskCount * sizeof(struct Task));
+            for (int i = 0; i < taskCount; i++)
+                taskPointers[i] = &copy[i];
+
+            int expectedCount = threaded ? threaded_simulate(type, workload, taskCount, expected)
+                                         : reference_simulate(type, workload, taskCount, expected);
+            int actualCount = simulate_policy(policy, taskPointers, taskCount, FUZZ_QUANTUM, FUZZ_TIMEOUT,
+                                              actual, MAX_DISPATCHES);
+            if (threaded)
+                actualCount = merge_dispatches(actual, actualCount);
+
+            int limit = expectedCount < MAX_DISPATCHES ? expectedCount : MAX_DISPATCHES;
+            int same = expectedCount == actualCount;
+            for (int i = 0; same && i < limit; i++)
+                same = expected[i].time == actual[i].time && expected[i].ID == actual[i].ID;
+
+            if (!same)
+            {
+                if (divergences < 10)
+                    print_divergence(policy, threaded, workload, taskCount, expected, expectedCount, actual,
+                                     actualCount);
+                divergences++;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    printf("%ld workloads x 6 policies in %.2f s (%.0f workloads/hour), %ld divergences\n",
+           workloads, seconds, workloads / (seconds > 0 ? seconds : 1e-9) * 3600, divergences);
+    return divergences > 0 ? 1 : 0;
+}
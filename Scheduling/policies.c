@@ -0,0 +1,408 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include "scheduling.h"
+#include "policies.h"
+
+#define FEEDBACK_LEVELS 3
+
+// Ready tasks are bits in a bitmap ordered by the policy's priority, with ties
+// broken by task index like the linear scans in schedulers.c. Picking the best
+// ready task is then a find-first-set over a few words.
+struct ReadyQueue
+{
+    struct Task **tasks;
+    int taskCount;
+    int quantum;
+    int words;
+    unsigned long long *bitmap[FEEDBACK_LEVELS]; // FEED has one bitmap per queue level
+    int *rank;                                   // Task index -> bit
+    int *byRank;                                 // Bit -> task index
+    int *level;                                  // FEED: queue level of each task
+    int *heap;                                   // SRT: binary heap of task indices
+    int heapSize;
+    int *list;                                   // HRRN: unordered ready tasks
+    int listSize;
+    int cursor;                                  // RR: where the round continues
+};
+
+struct RankKey
+{
+    int key;
+    int index;
+};
+
+static int compare_rank_key(const void *a, const void *b)
+{
+    const struct RankKey *left = a;
+    const struct RankKey *right = b;
+
+    if (left->key != right->key)
+        return left->key < right->key ? -1 : 1;
+    return left->index - right->index;
+}
+
+static struct ReadyQueue *queue_create(struct Task **tasks, int taskCount, int quantum, int levels)
+{
+    struct ReadyQueue *queue = calloc(1, sizeof(struct ReadyQueue));
+    queue->tasks = tasks;
+    queue->taskCount = taskCount;
+    queue->quantum = quantum;
+    queue->words = (taskCount + 63) / 64;
+    for (int l = 0; l < levels; l++)
+        queue->bitmap[l] = calloc(queue->words > 0 ? queue->words : 1, sizeof(unsigned long long));
+    queue->rank = malloc((taskCount > 0 ? taskCount : 1) * sizeof(int));
+    queue->byRank = malloc((taskCount > 0 ? taskCount : 1) * sizeof(int));
+    return queue;
+}
+
+// Order the bits by key, lowest key first
+static void queue_rank_by(struct ReadyQueue *queue, int (*key)(struct Task *task))
+{
+    struct RankKey *keys = malloc((queue->taskCount > 0 ? queue->taskCount : 1) * sizeof(struct RankKey));
+    for (int i = 0; i < queue->taskCount; i++)
+    {
+        keys[i].key = key ? key(queue->tasks[i]) : 0;
+        keys[i].index = i;
+    }
+    qsort(keys, queue->taskCount, sizeof(struct RankKey), compare_rank_key);
+
+    for (int r = 0; r < queue->taskCount; r++)
+    {
+        queue->byRank[r] = keys[r].index;
+        queue->rank[keys[r].index] = r;
+    }
+    free(keys);
+}
+
+static void queue_destroy(struct ReadyQueue *queue)
+{
+    for (int l = 0; l < FEEDBACK_LEVELS; l++)
+        free(queue->bitmap[l]);
+    free(queue->rank);
+    free(queue->byRank);
+    free(queue->level);
+    free(queue->heap);
+    free(queue->list);
+    free(queue);
+}
+
+static void bitmap_set(unsigned long long *bits, int bit)
+{
+    bits[bit / 64] |= 1ULL << (bit % 64);
+}
+
+static void bitmap_clear(unsigned long long *bits, int bit)
+{
+    bits[bit / 64] &= ~(1ULL << (bit % 64));
+}
+
+// First set bit at or after from, -1 if there is none
+static int bitmap_first(const unsigned long long *bits, int words, int from)
+{
+    int word = from / 64;
+    if (word >= words)
+        return -1;
+
+    unsigned long long masked = bits[word] & (~0ULL << (from % 64));
+    while (masked == 0)
+    {
+        if (++word == words)
+            return -1;
+        masked = bits[word];
+    }
+    return word * 64 + __builtin_ctzll(masked);
+}
+
+// Bitmap policies: FCFS, SPN and RR share everything except the ordering
+
+static void bitmap_enqueue(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    bitmap_set(queue->bitmap[0], queue->rank[taskIndex]);
+}
+
+static int bitmap_pick(struct ReadyQueue *queue, int *slice, int sliceLength)
+{
+    int bit = bitmap_first(queue->bitmap[0], queue->words, 0);
+    if (bit < 0)
+        return -1;
+
+    bitmap_clear(queue->bitmap[0], bit);
+    *slice = sliceLength;
+    return queue->byRank[bit];
+}
+
+static void destroy_queue(struct ReadyQueue *queue)
+{
+    queue_destroy(queue);
+}
+
+// First-Come, First-Served
+static int arrival_key(struct Task *task)
+{
+    return task->arrivalTime;
+}
+
+static struct ReadyQueue *fcfs_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, 1);
+    queue_rank_by(queue, arrival_key);
+    return queue;
+}
+
+static int fcfs_pick(struct ReadyQueue *queue, int now, int *slice)
+{
+    return bitmap_pick(queue, slice, RUN_TO_COMPLETION);
+}
+
+// Shortest Process Next
+static int runtime_key(struct Task *task)
+{
+    return task->totalRuntime;
+}
+
+static struct ReadyQueue *spn_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, 1);
+    queue_rank_by(queue, runtime_key);
+    return queue;
+}
+
+// Round Robin goes around the task table in index order, continuing after the last task it ran
+static struct ReadyQueue *rr_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, 1);
+    queue_rank_by(queue, NULL);
+    return queue;
+}
+
+static int rr_pick(struct ReadyQueue *queue, int now, int *slice)
+{
+    int bit = bitmap_first(queue->bitmap[0], queue->words, queue->cursor);
+    if (bit < 0)
+        bit = bitmap_first(queue->bitmap[0], queue->words, 0);
+    if (bit < 0)
+        return -1;
+
+    bitmap_clear(queue->bitmap[0], bit);
+    queue->cursor = (bit + 1) % queue->taskCount;
+    *slice = queue->quantum;
+    return bit;
+}
+
+static void rr_preempt(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    bitmap_set(queue->bitmap[0], taskIndex);
+}
+
+// Highest Response Ratio Next. The ratio changes with time, so there is no order to keep,
+// but comparing wait/runtime fractions by cross multiplication avoids the divisions.
+static struct ReadyQueue *hrrn_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, 0);
+    queue->list = malloc((taskCount > 0 ? taskCount : 1) * sizeof(int));
+    return queue;
+}
+
+static void hrrn_enqueue(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    queue->list[queue->listSize++] = taskIndex;
+}
+
+static int hrrn_pick(struct ReadyQueue *queue, int now, int *slice)
+{
+    if (queue->listSize == 0)
+        return -1;
+
+    int best = 0;
+    for (int i = 1; i < queue->listSize; i++)
+    {
+        struct Task *candidate = queue->tasks[queue->list[i]];
+        struct Task *current = queue->tasks[queue->list[best]];
+        long long lhs = (long long)(now - candidate->arrivalTime) * current->totalRuntime;
+        long long rhs = (long long)(now - current->arrivalTime) * candidate->totalRuntime;
+
+        if (lhs > rhs || (lhs == rhs && queue->list[i] < queue->list[best]))
+            best = i;
+    }
+
+    int taskIndex = queue->list[best];
+    queue->list[best] = queue->list[--queue->listSize];
+    *slice = RUN_TO_COMPLETION;
+    return taskIndex;
+}
+
+// Shortest Remaining Time, min-heap on (remaining time, index)
+static int srt_before(struct ReadyQueue *queue, int a, int b)
+{
+    int remainingA = queue->tasks[a]->totalRuntime - queue->tasks[a]->currentRuntime;
+    int remainingB = queue->tasks[b]->totalRuntime - queue->tasks[b]->currentRuntime;
+
+    return remainingA < remainingB || (remainingA == remainingB && a < b);
+}
+
+static struct ReadyQueue *srt_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, 0);
+    queue->heap = malloc((taskCount > 0 ? taskCount : 1) * sizeof(int));
+    return queue;
+}
+
+static void srt_enqueue(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    int child = queue->heapSize++;
+    while (child > 0)
+    {
+        int parent = (child - 1) / 2;
+        if (!srt_before(queue, taskIndex, queue->heap[parent]))
+            break;
+        queue->heap[child] = queue->heap[parent];
+        child = parent;
+    }
+    queue->heap[child] = taskIndex;
+}
+
+static int srt_pick(struct ReadyQueue *queue, int now, int *slice)
+{
+    if (queue->heapSize == 0)
+        return -1;
+
+    int taskIndex = queue->heap[0];
+    int last = queue->heap[--queue->heapSize];
+    int parent = 0;
+
+    while (2 * parent + 1 < queue->heapSize)
+    {
+        int child = 2 * parent + 1;
+        if (child + 1 < queue->heapSize && srt_before(queue, queue->heap[child + 1], queue->heap[child]))
+            child++;
+        if (!srt_before(queue, queue->heap[child], last))
+            break;
+        queue->heap[parent] = queue->heap[child];
+        parent = child;
+    }
+    if (queue->heapSize > 0)
+        queue->heap[parent] = last;
+
+    *slice = queue->quantum;
+    return taskIndex;
+}
+
+// Feedback with three levels, one quantum at the first, two at the second and unlimited at the last.
+// Within a level the earliest arrival goes first.
+static struct ReadyQueue *feed_create(struct Task **tasks, int taskCount, int quantum)
+{
+    struct ReadyQueue *queue = queue_create(tasks, taskCount, quantum, FEEDBACK_LEVELS);
+    queue_rank_by(queue, arrival_key);
+    queue->level = calloc(taskCount > 0 ? taskCount : 1, sizeof(int));
+    return queue;
+}
+
+static void feed_enqueue(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    bitmap_set(queue->bitmap[queue->level[taskIndex]], queue->rank[taskIndex]);
+}
+
+static int feed_pick(struct ReadyQueue *queue, int now, int *slice)
+{
+    for (int l = 0; l < FEEDBACK_LEVELS; l++)
+    {
+        int bit = bitmap_first(queue->bitmap[l], queue->words, 0);
+        if (bit < 0)
+            continue;
+
+        bitmap_clear(queue->bitmap[l], bit);
+        *slice = l == FEEDBACK_LEVELS - 1 ? RUN_TO_COMPLETION : (l + 1) * queue->quantum;
+        return queue->byRank[bit];
+    }
+    return -1;
+}
+
+static void feed_preempt(struct ReadyQueue *queue, int taskIndex, int now)
+{
+    if (queue->level[taskIndex] < FEEDBACK_LEVELS - 1)
+        queue->level[taskIndex]++;
+    feed_enqueue(queue, taskIndex, now);
+}
+
+const struct Policy policies[] = {
+    [FCFS] = {"FCFS", fcfs_create, bitmap_enqueue, fcfs_pick, bitmap_enqueue, destroy_queue},
+    [SPN] = {"SPN", spn_create, bitmap_enqueue, fcfs_pick, bitmap_enqueue, destroy_queue},
+    [RR] = {"RR", rr_create, bitmap_enqueue, rr_pick, rr_preempt, destroy_queue},
+    [HRRN] = {"HRRN", hrrn_create, hrrn_enqueue, hrrn_pick, hrrn_enqueue, destroy_queue},
+    [SRT] = {"SRT", srt_create, srt_enqueue, srt_pick, srt_enqueue, destroy_queue},
+    [FEED] = {"FEED", feed_create, feed_enqueue, feed_pick, feed_preempt, destroy_queue},
+};
+
+int simulate_policy(const struct Policy *policy, struct Task **tasks, int taskCount, int quantum, int timeout,
+                    struct Dispatch *trace, int traceCapacity)
+{
+    struct ReadyQueue *queue = policy->create(tasks, taskCount, quantum);
+
+    // Admit tasks in arrival order
+    struct RankKey *arrivals = malloc((taskCount > 0 ? taskCount : 1) * sizeof(struct RankKey));
+    for (int i = 0; i < taskCount; i++)
+    {
+        arrivals[i].key = tasks[i]->arrivalTime;
+        arrivals[i].index = i;
+    }
+    qsort(arrivals, taskCount, sizeof(struct RankKey), compare_rank_key);
+
+    int now = 0;
+    int admitted = 0;
+    int tasksFinished = 0;
+    int dispatches = 0;
+
+    while (tasksFinished < taskCount && now < timeout)
+    {
+        while (admitted < taskCount && arrivals[admitted].key <= now)
+            policy->enqueue(queue, arrivals[admitted++].index, now);
+
+        int slice;
+        int taskIndex = policy->pick(queue, now, &slice);
+        if (taskIndex < 0)
+        {
+            // Nothing ready, skip straight to the next arrival
+            if (admitted == taskCount)
+                break;
+            now = arrivals[admitted].key;
+            continue;
+        }
+
+        struct Task *task = tasks[taskIndex];
+        if (dispatches < traceCapacity)
+        {
+            trace[dispatches].time = now;
+            trace[dispatches].ID = task->ID;
+        }
+        dispatches++;
+
+        if (task->startTime == -1)
+            task->startTime = now;
+        task->state = running;
+
+        int run = task->totalRuntime - task->currentRuntime;
+        if (slice != RUN_TO_COMPLETION && slice < run)
+            run = slice;
+        if (run > timeout - now)
+            run = timeout - now;
+        now += run;
+        task->currentRuntime += run;
+
+        if (task->currentRuntime == task->totalRuntime)
+        {
+            task->state = finished;
+            tasksFinished++;
+        }
+        else
+        {
+            task->state = preempted;
+            policy->preempt(queue, taskIndex, now);
+        }
+    }
+
+    free(arrivals);
+    policy->destroy(queue);
+    return dispatches;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Virtual-time versions of the six classic schedulers in schedulers.c.
+// Each policy keeps its own ready structure so a scheduling decision does not
+// have to scan the whole task table like the threaded schedulers do.
+
+struct ReadyQueue;
+
+struct Policy
+{
+    const char *name;
+    struct ReadyQueue *(*create)(struct Task **tasks, int taskCount, int quantum);
+    void (*enqueue)(struct ReadyQueue *queue, int taskIndex, int now);  // Task arrived
+    int (*pick)(struct ReadyQueue *queue, int now, int *slice);          // Removes the next task, -1 when none is ready
+    void (*preempt)(struct ReadyQueue *queue, int taskIndex, int now);  // Task used up its slice and is ready again
+    void (*destroy)(struct ReadyQueue *queue);
+};
+
+// Indexed by SchedulerType, FCFS through FEED
+extern const struct Policy policies[];
+
+#define RUN_TO_COMPLETION -1
+
+struct Dispatch
+{
+    int time;
+    int ID;
+};
+
+// Run the tasks to completion (or timeout) under a policy without any threads.
+// Fills trace with up to traceCapacity dispatches and returns how many there were.
+int simulate_policy(const struct Policy *policy, struct Task **tasks, int taskCount, int quantum, int timeout,
+                    struct Dispatch *trace, int traceCapacity);
@@ -0,0 +1,494 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <string.h>
+#include <math.h>
+#include "scheduling.h"
+#include "file_handling.h"
+#include "realtime.h"
+#include "telemetry.h"
+
+#define SERVER_INDEX -2
+#define IDLE_INDEX -1
+
+const char *serverTypeString[] = {
+    "background", "polling", "deferrable", "sporadic"};
+
+// xorshift64*, small and good enough to draw arrivals and runtimes
+static unsigned long long rt_random(struct AperiodicSource *source)
+{
+    source->rngState ^= source->rngState >> 12;
+    source->rngState ^= source->rngState << 25;
+    source->rngState ^= source->rngState >> 27;
+    return source->rngState * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform in (0, 1]
+static double rt_uniform(struct AperiodicSource *source)
+{
+    return ((rt_random(source) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static void rt_draw_next_arrival(struct AperiodicSource *source, int now)
+{
+    if (source->remainingCount <= 0)
+    {
+        source->nextArrival = -1;
+        return;
+    }
+
+    // Exponential interarrival gives a Poisson stream, runtimes are uniform around the mean
+    source->nextArrival = now + (int)ceil(-source->meanInterarrival * log(rt_uniform(source)));
+    source->nextRuntime = 1 + (int)(rt_random(source) % (2 * source->meanRuntime - 1));
+    source->remainingCount--;
+}
+
+static struct AperiodicRequest *rt_push_request(struct AperiodicRequest **requests, int *count, int *capacity)
+{
+    if (*count == *capacity)
+    {
+        *capacity = *capacity > 0 ? *capacity * 2 : 16;
+        *requests = realloc(*requests, *capacity * sizeof(struct AperiodicRequest));
+        if (*requests == NULL)
+        {
+            perror("Failed to grow aperiodic request list");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return &(*requests)[(*count)++];
+}
+
+void rt_add_request(struct RtSimulation *sim, int id, int arrivalTime, int runtime)
+{
+    struct AperiodicRequest *request = rt_push_request(&sim->scheduled, &sim->scheduledCount, &sim->scheduledCapacity);
+    request->ID = id;
+    request->arrivalTime = arrivalTime;
+    request->runtime = runtime;
+    request->remaining = runtime;
+    request->startTime = -1;
+    request->finishTime = -1;
+}
+
+static int compare_arrival(const void *a, const void *b)
+{
+    const struct AperiodicRequest *left = a;
+    const struct AperiodicRequest *right = b;
+
+    if (left->arrivalTime != right->arrivalTime)
+        return left->arrivalTime - right->arrivalTime;
+    return left->ID - right->ID;
+}
+
+void rt_prepare(struct RtSimulation *sim, SchedulerType policy, int horizon)
+{
+    sim->policy = policy;
+    sim->horizon = horizon;
+    sim->now = 0;
+    sim->running = IDLE_INDEX;
+
+    qsort(sim->scheduled, sim->scheduledCount, sizeof(struct AperiodicRequest), compare_arrival);
+    sim->nextScheduled = 0;
+
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        if (task->deadline <= 0)
+            task->deadline = task->period;
+        // Only one job of a task is tracked at a time, so it has to finish within its period
+        if (task->deadline > task->period)
+        {
+            guarded_printf(stderr, "Task %d: deadline %d is longer than its period %d\n", task->ID, task->deadline,
+                           task->period);
+            exit(1);
+        }
+        task->state = idle;
+        task->release = 0;
+        task->remaining = 0;
+        task->jobsReleased = 0;
+        task->jobsCompleted = 0;
+        task->deadlineMisses = 0;
+    }
+
+    struct Server *server = &sim->server;
+    server->state = idle;
+    server->capacity = server->budget;
+    server->periodStart = 0;
+    server->activeSince = -1;
+    server->consumed = 0;
+    server->replenishmentCount = 0;
+
+    rt_draw_next_arrival(&sim->source, 0);
+}
+
+static int queue_length(struct RtSimulation *sim)
+{
+    return sim->requestCount - sim->queueHead;
+}
+
+static void set_periodic_state(int time, FILE *log, struct PeriodicTask *task, enum taskState newState)
+{
+    if (task->state == newState)
+        return;
+
+    guarded_printf(log, "%d: Task %d: %s -> %s, total time worked: %d \n",
+                   time, task->ID, taskStateString[task->state], taskStateString[newState], task->wcet - task->remaining);
+    task->state = newState;
+}
+
+static void set_server_state(struct RtSimulation *sim, FILE *log, enum taskState newState)
+{
+    if (sim->server.state == newState)
+        return;
+
+    guarded_printf(log, "%d: Server: %s -> %s, capacity left: %d \n",
+                   sim->now, taskStateString[sim->server.state], taskStateString[newState], sim->server.capacity);
+    sim->server.state = newState;
+}
+
+// Abort jobs that passed their deadline and release new jobs
+static void rt_release_jobs(struct RtSimulation *sim, FILE *log)
+{
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+
+        if (task->remaining > 0 && sim->now >= task->release + task->deadline)
+        {
+            task->deadlineMisses++;
+            guarded_printf(log, "%d: Task %d: missed deadline of job %d with %d time units left \n",
+                           sim->now, task->ID, task->jobsReleased, task->remaining);
+            task->remaining = 0;
+            set_periodic_state(sim->now, log, task, idle);
+        }
+
+        int nextRelease = task->jobsReleased == 0 ? 0 : task->release + task->period;
+        if (sim->now >= nextRelease)
+        {
+            task->release = nextRelease;
+            task->remaining = task->wcet;
+            task->jobsReleased++;
+            if (task->state == finished)
+                task->state = idle;
+        }
+    }
+}
+
+static void rt_admit_requests(struct RtSimulation *sim, FILE *log)
+{
+    while (sim->nextScheduled < sim->scheduledCount
+           && sim->scheduled[sim->nextScheduled].arrivalTime <= sim->now)
+    {
+        *rt_push_request(&sim->requests, &sim->requestCount, &sim->requestCapacity) = sim->scheduled[sim->nextScheduled++];
+        guarded_printf(log, "%d: Aperiodic %d: arrived with runtime %d \n",
+                       sim->now, sim->requests[sim->requestCount - 1].ID, sim->requests[sim->requestCount - 1].runtime);
+    }
+
+    struct AperiodicSource *source = &sim->source;
+    while (source->nextArrival >= 0 && source->nextArrival <= sim->now)
+    {
+        struct AperiodicRequest *request = rt_push_request(&sim->requests, &sim->requestCount, &sim->requestCapacity);
+        request->ID = source->nextID++;
+        request->arrivalTime = source->nextArrival;
+        request->runtime = source->nextRuntime;
+        request->remaining = source->nextRuntime;
+        request->startTime = -1;
+        request->finishTime = -1;
+        guarded_printf(log, "%d: Aperiodic %d: arrived with runtime %d \n", sim->now, request->ID, request->runtime);
+
+        rt_draw_next_arrival(source, source->nextArrival);
+    }
+}
+
+static void rt_replenish_server(struct RtSimulation *sim)
+{
+    struct Server *server = &sim->server;
+
+    switch (server->type)
+    {
+    case POLLING:
+    case DEFERRABLE:
+        if (sim->now % server->period == 0)
+        {
+            server->periodStart = sim->now;
+            server->capacity = server->budget;
+
+            // A polling server that finds nothing to do gives up its budget until the next period
+            if (server->type == POLLING && queue_length(sim) == 0)
+                server->capacity = 0;
+        }
+        break;
+    case SPORADIC:
+    {
+        int kept = 0;
+        for (int i = 0; i < server->replenishmentCount; i++)
+        {
+            if (server->replenishments[i].time <= sim->now)
+                server->capacity += server->replenishments[i].amount;
+            else
+                server->replenishments[kept++] = server->replenishments[i];
+        }
+        server->replenishmentCount = kept;
+        if (server->capacity > server->budget)
+            server->capacity = server->budget;
+        break;
+    }
+    case BACKGROUND:
+        break;
+    }
+}
+
+// Sporadic server: schedule the return of the capacity used during the active period
+static void rt_end_sporadic_activity(struct Server *server)
+{
+    if (server->activeSince < 0)
+        return;
+
+    if (server->consumed > 0)
+    {
+        if (server->replenishmentCount == MAX_REPLENISHMENTS)
+        {
+            // Out of slots, fold into the latest pending replenishment (only ever delays budget)
+            struct Replenishment *last = &server->replenishments[MAX_REPLENISHMENTS - 1];
+            last->time = server->activeSince + server->period;
+            last->amount += server->consumed;
+        }
+        else
+        {
+            server->replenishments[server->replenishmentCount].time = server->activeSince + server->period;
+            server->replenishments[server->replenishmentCount].amount = server->consumed;
+            server->replenishmentCount++;
+        }
+    }
+    server->activeSince = -1;
+    server->consumed = 0;
+}
+
+static int server_deadline(struct RtSimulation *sim)
+{
+    struct Server *server = &sim->server;
+
+    if (server->type == SPORADIC)
+        return (server->activeSince >= 0 ? server->activeSince : sim->now) + server->period;
+    return server->periodStart + server->period;
+}
+
+// Fixed priority is deadline monotonic (rate monotonic for implicit deadlines), EDF uses absolute deadlines.
+// Ties go to the server, then to the task listed first.
+static int rt_pick(struct RtSimulation *sim)
+{
+    int priorityId = IDLE_INDEX;
+    int bestKey = 0;
+
+    struct Server *server = &sim->server;
+    if (server->type != BACKGROUND && server->capacity > 0 && queue_length(sim) > 0)
+    {
+        priorityId = SERVER_INDEX;
+        bestKey = sim->policy == EDF ? server_deadline(sim) : server->period;
+    }
+
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        if (task->remaining == 0)
+            continue;
+
+        int key = sim->policy == EDF ? task->release + task->deadline : task->deadline;
+        if (priorityId == IDLE_INDEX || key < bestKey)
+        {
+            bestKey = key;
+            priorityId = i;
+        }
+    }
+
+    // Background service uses whatever time the periodic tasks leave
+    if (priorityId == IDLE_INDEX && server->type == BACKGROUND && queue_length(sim) > 0)
+        priorityId = SERVER_INDEX;
+
+    return priorityId;
+}
+
+static void rt_serve_aperiodic(struct RtSimulation *sim, FILE *log)
+{
+    struct Server *server = &sim->server;
+    struct AperiodicRequest *request = &sim->requests[sim->queueHead];
+
+    if (request->startTime == -1)
+        request->startTime = sim->now;
+    request->remaining--;
+
+    if (server->type != BACKGROUND)
+    {
+        server->capacity--;
+        server->consumed++;
+    }
+
+    if (request->remaining == 0)
+    {
+        request->finishTime = sim->now + 1;
+        sim->queueHead++;
+        guarded_printf(log, "%d: Aperiodic %d: finished, response time %d \n",
+                       sim->now + 1, request->ID, request->finishTime - request->arrivalTime);
+    }
+
+    if (server->type == POLLING && queue_length(sim) == 0)
+        server->capacity = 0;
+}
+
+// Advance the simulation by one time unit
+void rt_step(struct RtSimulation *sim, FILE *log)
+{
+    rt_release_jobs(sim, log);
+    rt_admit_requests(sim, log);
+    rt_replenish_server(sim);
+
+    int next = rt_pick(sim);
+
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        if (i == next)
+            set_periodic_state(sim->now, log, task, running);
+        else if (task->state == running)
+            set_periodic_state(sim->now, log, task, preempted);
+    }
+    if (next == SERVER_INDEX)
+    {
+        if (sim->server.type == SPORADIC && sim->server.activeSince < 0)
+            sim->server.activeSince = sim->now;
+        set_server_state(sim, log, running);
+    }
+    else if (sim->server.state == running)
+        set_server_state(sim, log, queue_length(sim) > 0 ? preempted : idle);
+    sim->running = next;
+
+    if (next == SERVER_INDEX)
+    {
+        rt_serve_aperiodic(sim, log);
+    }
+    else if (next != IDLE_INDEX)
+    {
+        struct PeriodicTask *task = &sim->periodic[next];
+        if (--task->remaining == 0)
+        {
+            task->jobsCompleted++;
+            set_periodic_state(sim->now + 1, log, task, finished);
+        }
+    }
+
+    struct Server *server = &sim->server;
+    if (server->type == SPORADIC && (server->capacity == 0 || queue_length(sim) == 0))
+        rt_end_sporadic_activity(server);
+
+    sim->now++;
+}
+
+static void rt_publish(struct RtSimulation *sim)
+{
+    long long ready = queue_length(sim);
+    long long completed = sim->queueHead;
+    long long misses = 0;
+
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        ready += sim->periodic[i].remaining > 0;
+        completed += sim->periodic[i].jobsCompleted;
+        misses += sim->periodic[i].deadlineMisses;
+    }
+
+    struct Telemetry *telemetry = sim->telemetry;
+    telemetry_begin_write(telemetry);
+    telemetry->policy = sim->policy;
+    telemetry->virtualTime = sim->now;
+    telemetry->readyQueueLength = ready;
+    telemetry->completed[sim->policy] = completed;
+    telemetry->deadlineMisses = misses;
+    telemetry->aperiodicServed = sim->queueHead;
+    telemetry_end_write(telemetry);
+}
+
+// Run until the given time or the end of the horizon, whichever comes first
+void rt_run(struct RtSimulation *sim, int until, FILE *log)
+{
+    while (sim->now < until && sim->now < sim->horizon)
+    {
+        rt_step(sim, log);
+        if (sim->telemetry != NULL && sim->now % TELEMETRY_INTERVAL == 0)
+            rt_publish(sim);
+    }
+
+    if (sim->telemetry != NULL)
+        rt_publish(sim);
+}
+
+static int compare_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// Nearest-rank percentile of a sorted list
+static int percentile(const int *sorted, int count, int percent)
+{
+    int rank = (percent * count + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void rt_print_summary(struct RtSimulation *sim, FILE *output)
+{
+    int totalMisses = 0;
+
+    guarded_printf(output, "Summary of %s scheduling with a %s server after %d time units \n",
+                   sim->policy == EDF ? "EDF" : "fixed priority", serverTypeString[sim->server.type], sim->now);
+
+    for (int i = 0; i < sim->periodicCount; i++)
+    {
+        struct PeriodicTask *task = &sim->periodic[i];
+        guarded_printf(output, "Periodic task %d (period %d, wcet %d, deadline %d): released %d jobs, completed %d, missed %d deadlines \n",
+                       task->ID, task->period, task->wcet, task->deadline, task->jobsReleased, task->jobsCompleted, task->deadlineMisses);
+        totalMisses += task->deadlineMisses;
+    }
+    guarded_printf(output, "Periodic deadline misses: %d \n", totalMisses);
+
+    int served = sim->queueHead;
+    guarded_printf(output, "Aperiodic requests: %d arrived, %d served, %d still queued \n",
+                   sim->requestCount, served, queue_length(sim));
+    if (served == 0)
+        return;
+
+    int *responseTimes = malloc(served * sizeof(int));
+    long long sum = 0;
+    for (int i = 0; i < served; i++)
+    {
+        responseTimes[i] = sim->requests[i].finishTime - sim->requests[i].arrivalTime;
+        sum += responseTimes[i];
+    }
+    qsort(responseTimes, served, sizeof(int), compare_int);
+
+    guarded_printf(output, "Aperiodic response time: min %d, mean %.2f, p50 %d, p90 %d, p99 %d, max %d \n",
+                   responseTimes[0], (double)sum / served, percentile(responseTimes, served, 50),
+                   percentile(responseTimes, served, 90), percentile(responseTimes, served, 99), responseTimes[served - 1]);
+
+    // Histogram with power-of-two buckets
+    guarded_printf(output, "Aperiodic response time distribution \n");
+    int i = 0;
+    for (int low = 0, high = 1; i < served; low = high, high *= 2)
+    {
+        int count = 0;
+        while (i < served && responseTimes[i] < high)
+        {
+            count++;
+            i++;
+        }
+        if (count > 0)
+            guarded_printf(output, "  [%d, %d): %d \n", low, high, count);
+    }
+
+    free(responseTimes);
+}
+
+void rt_free(struct RtSimulation *sim)
+{
+    free(sim->periodic);
+    free(sim->scheduled);
+    free(sim->requests);
+    free(sim);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#define MAX_REPLENISHMENTS 16
+
+// How soft aperiodic requests are served next to the hard periodic tasks
+enum serverType
+{
+    BACKGROUND, // No server, aperiodic work only runs when no periodic job is ready
+    POLLING,    // Budget refilled every period, dropped as soon as the queue is empty
+    DEFERRABLE, // Budget refilled every period, kept while the queue is empty
+    SPORADIC    // Consumed budget returned one period after the server became active
+};
+
+extern const char *serverTypeString[];
+
+struct PeriodicTask
+{
+    enum taskState state;
+    int ID;
+    int period;         // In some imaginary integer time unit
+    int wcet;           // In some imaginary integer time unit
+    int deadline;       // Relative deadline, defaults to the period
+    int release;        // Release time of the current job
+    int remaining;      // Remaining execution time of the current job
+    int jobsReleased;
+    int jobsCompleted;
+    int deadlineMisses;
+};
+
+struct AperiodicRequest
+{
+    int ID;
+    int arrivalTime;    // In some imaginary integer time unit
+    int runtime;        // In some imaginary integer time unit
+    int remaining;      // In some imaginary integer time unit
+    int startTime;      // -1 until first served
+    int finishTime;     // -1 until completed
+};
+
+struct Replenishment
+{
+    int time;
+    int amount;
+};
+
+struct Server
+{
+    enum serverType type;
+    enum taskState state;
+    int period;
+    int budget;
+    int capacity;       // Budget left in the current period
+    int periodStart;    // Polling/deferrable: start of the current server period
+    int activeSince;    // Sporadic: time the server became active, -1 while idle
+    int consumed;       // Sporadic: capacity used since activeSince
+    int replenishmentCount;
+    struct Replenishment replenishments[MAX_REPLENISHMENTS];
+};
+
+// Random Poisson stream of aperiodic requests, drawn lazily as time advances
+struct AperiodicSource
+{
+    int nextID;
+    int remainingCount;
+    int meanInterarrival;
+    int meanRuntime;
+    int nextArrival;    // -1 when the source is exhausted
+    int nextRuntime;
+    unsigned long long rngState;
+};
+
+struct RtSimulation
+{
+    SchedulerType policy;
+    int now;            // Virtual time
+    int horizon;
+
+    struct PeriodicTask *periodic;
+    int periodicCount;
+
+    // Explicit requests from the task file, sorted by arrival time
+    struct AperiodicRequest *scheduled;
+    int scheduledCount;
+    int scheduledCapacity;
+    int nextScheduled;
+
+    // Every aperiodic request that has arrived so far, in arrival order.
+    // Requests are served FIFO, so requests[queueHead .. requestCount) is the queue
+    struct AperiodicRequest *requests;
+    int requestCount;
+    int requestCapacity;
+    int queueHead;
+
+    struct Server server;
+    struct AperiodicSource source;
+
+    int running;        // Index into periodic, -2 for the server, -1 when idle
+
+    struct Telemetry *telemetry; // Live counters, NULL when not published (not checkpointed)
+};
+
+void rt_add_request(struct RtSimulation *sim, int id, int arrivalTime, int runtime);
+// Resets the simulation to time 0. A periodic task without a deadline gets its period,
+// deadlines longer than the period are not supported and end the program.
+void rt_prepare(struct RtSimulation *sim, SchedulerType policy, int horizon);
+void rt_step(struct RtSimulation *sim, FILE *log);
+void rt_run(struct RtSimulation *sim, int until, FILE *log);
+void rt_print_summary(struct RtSimulation *sim, FILE *output);
+void rt_free(struct RtSimulation *sim);
@@ -289,7 +289,8 @@ void shortest_remaining_time(struct Task **tasks, int taskCount, int timeout, in
 
                 runningTask = tasks[priorityId];
                 set_task_state(runningTask, running);
-                runningTask->startTime = globalTime;
+                if (runningTask->startTime == -1)
+                    runningTask->startTime = globalTime;
             }
         }
 
@@ -321,7 +322,6 @@ void feedback(struct Task **tasks, int taskCount, int timeout, int quantum) {
     for (int i = 0; i < taskCount; i++) qeueu[i] = 0;
 
     int tasksFinished = 0;
-    int priorityId;
     struct Task *runningTask = NULL;
     
     while (tasksFinished < taskCount && globalTime < timeout) {
@@ -356,7 +356,8 @@ void feedback(struct Task **tasks, int taskCount, int timeout, int quantum) {
         } else {
 
             runningTask = tasks[priorityId];
-            runningTask->startTime = globalTime;
+            if (runningTask->startTime == -1)
+                runningTask->startTime = globalTime;
             set_task_state(runningTask, running);
         }
         switch (priorityQeueu) {
@@ -7,6 +7,9 @@
 #include "scheduling.h"
 #include "file_handling.h"
 #include "schedulers.h"
+#include "realtime.h"
+#include "checkpoint.h"
+#include "telemetry.h"
 
 volatile int globalTime = 0;
 
@@ -20,6 +23,34 @@ const char *taskStateString[] = {
 // File pointer for logging
 FILE *logFile;
 
+// Live counters published with --telemetry, read with telemetry_view
+static struct Telemetry *telemetry;
+static struct Task **telemetryTasks;
+static int telemetryTaskCount;
+
+static void usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s <scheduler_type> [task_file] [--checkpoint <time> <file>] [--resume <file>] [--horizon <time>] [--telemetry]\n", program);
+	exit(EXIT_FAILURE);
+}
+
+// The run goes on without telemetry if the shared memory can not be set up
+static struct Telemetry *start_telemetry(SchedulerType scheduler)
+{
+	struct Telemetry *created = telemetry_create(TELEMETRY_NAME, scheduler);
+	if (created == NULL)
+		perror("Warning: could not create telemetry " TELEMETRY_NAME ", running without it");
+	return created;
+}
+
+static int has_flag(int argc, char *argv[], const char *flag)
+{
+	for (int i = 2; i < argc; i++)
+		if (strcmp(argv[i], flag) == 0)
+			return 1;
+	return 0;
+}
+
 SchedulerType select_scheduler(const char *arg)
 {
 	if (strcmp(arg, "FCFS") == 0)
@@ -34,6 +65,10 @@ SchedulerType select_scheduler(const char *arg)
 		return SRT;
 	else if (strcmp(arg, "FEED") == 0)
 		return FEED;
+	else if (strcmp(arg, "FP") == 0)
+		return FP;
+	else if (strcmp(arg, "EDF") == 0)
+		return EDF;
 	else
 	{
 		fprintf(stderr, "Unknown scheduler type: %s\n", arg);
@@ -50,6 +85,22 @@ void *timer_function(void *arg)
 		globalTime++;
 		pthread_cond_broadcast(&timeCond); // Signal all waiting threads
 		pthread_mutex_unlock(&timeMutex);
+
+		if (telemetry != NULL)
+		{
+			long long ready = 0, completed = 0;
+			for (int i = 0; i < telemetryTaskCount; i++)
+			{
+				ready += telemetryTasks[i]->state != finished && telemetryTasks[i]->arrivalTime <= globalTime;
+				completed += telemetryTasks[i]->state == finished;
+			}
+
+			telemetry_begin_write(telemetry);
+			telemetry->virtualTime = globalTime;
+			telemetry->readyQueueLength = ready;
+			telemetry->completed[telemetry->policy] = completed;
+			telemetry_end_write(telemetry);
+		}
 	}
 	return NULL;
 }
@@ -90,14 +141,102 @@ void *task_handler(void *var)
 	return NULL;
 }
 
-int main(int argc, char *argv[])
+// Periodic tasks and aperiodic requests run in virtual time, no task threads or timer needed.
+// Options after the scheduler type:
+//   --checkpoint <time> <file>  snapshot the simulation when virtual time reaches <time>
+//   --resume <file>             continue from a snapshot instead of reading the task file,
+//                               possibly with another scheduler to fork the run
+//   --horizon <time>            simulate until <time>, also extends a resumed run
+//   --telemetry                 publish live counters for telemetry_view
+int run_realtime(SchedulerType scheduler, int argc, char *argv[], int timeout)
 {
-	if (argc < 2)
+	char *taskFile = "rt_tasks.txt";
+	char *checkpointFile = NULL;
+	char *resumeFile = NULL;
+	int checkpointTime = -1;
+	int horizon = -1;
+
+	for (int i = 2; i < argc; i++)
 	{
-		fprintf(stderr, "Usage: %s <scheduler_type>\n", argv[0]);
-		exit(EXIT_FAILURE);
+		if (strcmp(argv[i], "--checkpoint") == 0)
+		{
+			if (i + 2 >= argc)
+				usage(argv[0]);
+			checkpointTime = atoi(argv[++i]);
+			checkpointFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--resume") == 0)
+		{
+			if (i + 1 >= argc)
+				usage(argv[0]);
+			resumeFile = argv[++i];
+		}
+		else if (strcmp(argv[i], "--horizon") == 0)
+		{
+			if (i + 1 >= argc)
+				usage(argv[0]);
+			horizon = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--telemetry") == 0)
+			continue;
+		else
+			taskFile = argv[i];
 	}
 
+	struct RtSimulation *sim;
+	if (resumeFile != NULL)
+	{
+		sim = rt_load_checkpoint(resumeFile);
+		if (sim == NULL)
+		{
+			fprintf(stderr, "Failed to load checkpoint %s\n", resumeFile);
+			exit(EXIT_FAILURE);
+		}
+		sim->policy = scheduler;
+		if (horizon >= 0)
+			sim->horizon = horizon;
+		guarded_printf(stdout, "Resuming %s at time %d\n", resumeFile, sim->now);
+	}
+	else
+	{
+		sim = read_rt_tasks_from_file(taskFile);
+		rt_prepare(sim, scheduler, horizon >= 0 ? horizon : timeout);
+	}
+
+	guarded_printf(stdout, "Using %s scheduler with a %s server\n",
+				   scheduler == EDF ? "Earliest Deadline First" : "Fixed Priority", serverTypeString[sim->server.type]);
+
+	if (has_flag(argc, argv, "--telemetry"))
+		sim->telemetry = telemetry = start_telemetry(scheduler);
+
+	if (checkpointFile != NULL)
+	{
+		rt_run(sim, checkpointTime, logFile);
+		if (rt_save_checkpoint(sim, checkpointFile) != 0)
+		{
+			perror("Failed to write checkpoint");
+			exit(EXIT_FAILURE);
+		}
+		guarded_printf(stdout, "Checkpoint written to %s at time %d\n", checkpointFile, sim->now);
+	}
+	rt_run(sim, sim->horizon, logFile);
+	rt_print_summary(sim, stdout);
+
+	if (telemetry != NULL)
+		telemetry_destroy(telemetry, TELEMETRY_NAME);
+	rt_free(sim);
+	fclose(logFile);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+		usage(argv[0]);
+
+	// Select the scheduler to use based on bash argument
+	SchedulerType scheduler = select_scheduler(argv[1]);
+
 	int taskCount;
 
 	// Initialize log file
@@ -110,8 +249,20 @@ int main(int argc, char *argv[])
 		exit(EXIT_FAILURE);
 	}
 
+	int schedulerTimeout = 2500;
+
+	if (scheduler == FP || scheduler == EDF)
+		return run_realtime(scheduler, argc, argv, schedulerTimeout);
+
 	// Read tasks from the file
-	struct Task **tasks = read_tasks_from_file("tasks.txt", &taskCount);
+	struct Task **tasks = read_tasks_from_file(argc > 2 && argv[2][0] != '-' ? argv[2] : "tasks.txt", &taskCount);
+
+	if (has_flag(argc, argv, "--telemetry"))
+	{
+		telemetryTasks = tasks;
+		telemetryTaskCount = taskCount;
+		telemetry = start_telemetry(scheduler);
+	}
 
 	// Create task threads
 	pthread_t threads[taskCount];
@@ -134,7 +285,6 @@ int main(int argc, char *argv[])
 	}
 
 	sleep(1); // Let everything stabilize
-	int schedulerTimeout = 2500;
 
 	// Start the global timer thread
 	pthread_t timerThread;
@@ -144,8 +294,6 @@ int main(int argc, char *argv[])
 		return 1;
 	}
 
-	// Select the scheduler to use based on bash argument
-	SchedulerType scheduler = select_scheduler(argv[1]);
 	switch (scheduler)
 	{
 	case FCFS:
@@ -189,6 +337,8 @@ int main(int argc, char *argv[])
 	}
 
 	// Cleanup
+	if (telemetry != NULL)
+		telemetry_destroy(telemetry, TELEMETRY_NAME);
 	for (int i = 0; i < taskCount; i++)
 		free(tasks[i]); // Free each task
 	free(tasks);		// Free the task array
@@ -13,7 +13,9 @@ typedef enum
     RR,   // Round Robin
     HRRN,
     SRT,
-    FEED
+    FEED,
+    FP,   // Fixed priority, periodic tasks with an aperiodic server
+    EDF   // Earliest Deadline First, periodic tasks with an aperiodic server
 } SchedulerType;
 
 enum taskState
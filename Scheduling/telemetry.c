@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "telemetry.h"
+
+struct Telemetry *telemetry_create(const char *name, int policy)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return NULL;
+
+    if (ftruncate(fd, sizeof(struct Telemetry)) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    struct Telemetry *telemetry = mmap(NULL, sizeof(struct Telemetry), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (telemetry == MAP_FAILED)
+        return NULL;
+
+    // Keep counting from the old sequence since a viewer may still be attached to a segment
+    // from an earlier run, but make it even again if that run died in the middle of an update
+    if (telemetry->sequence & 1)
+        telemetry->sequence++;
+    telemetry_begin_write(telemetry);
+    telemetry->magic = TELEMETRY_MAGIC;
+    telemetry->version = TELEMETRY_VERSION;
+    telemetry->pid = getpid();
+    telemetry->policy = policy;
+    telemetry->virtualTime = 0;
+    telemetry->readyQueueLength = 0;
+    memset(telemetry->completed, 0, sizeof(telemetry->completed));
+    telemetry->deadlineMisses = 0;
+    telemetry->aperiodicServed = 0;
+    telemetry_end_write(telemetry);
+
+    return telemetry;
+}
+
+struct Telemetry *telemetry_attach(const char *name)
+{
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return NULL;
+
+    struct Telemetry *telemetry = mmap(NULL, sizeof(struct Telemetry), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (telemetry == MAP_FAILED)
+        return NULL;
+
+    if (telemetry->magic != TELEMETRY_MAGIC || telemetry->version != TELEMETRY_VERSION)
+    {
+        munmap(telemetry, sizeof(struct Telemetry));
+        return NULL;
+    }
+    return telemetry;
+}
+
+void telemetry_begin_write(struct Telemetry *telemetry)
+{
+    __atomic_store_n(&telemetry->sequence, telemetry->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void telemetry_end_write(struct Telemetry *telemetry)
+{
+    __atomic_store_n(&telemetry->sequence, telemetry->sequence + 1, __ATOMIC_RELEASE);
+}
+
+void telemetry_read(const struct Telemetry *telemetry, struct Telemetry *snapshot)
+{
+    unsigned int before, after;
+
+    do
+    {
+        before = __atomic_load_n(&telemetry->sequence, __ATOMIC_ACQUIRE);
+        memcpy(snapshot, (const void *)telemetry, sizeof(struct Telemetry));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&telemetry->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+}
+
+void telemetry_destroy(struct Telemetry *telemetry, const char *name)
+{
+    munmap(telemetry, sizeof(struct Telemetry));
+    shm_unlink(name);
+}
+
+void telemetry_detach(struct Telemetry *telemetry)
+{
+    munmap((void *)telemetry, sizeof(struct Telemetry));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#define TELEMETRY_NAME "/ttk4147_scheduling"
+#define TELEMETRY_MAGIC 0x54454c45 // "TELE"
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_POLICIES 8       // One slot per SchedulerType
+#define TELEMETRY_INTERVAL 64      // Virtual time units between updates from the real-time simulator
+
+// Live counters shared with telemetry_view. The simulator is the only writer and never
+// waits for readers: sequence is odd while an update is in progress, and a reader
+// retries its copy if the sequence was odd or changed underneath it (a seqlock).
+struct Telemetry
+{
+    unsigned int magic;
+    unsigned int version;
+    volatile unsigned int sequence;
+    int pid;
+    int policy;
+    long long virtualTime;
+    long long readyQueueLength;
+    long long completed[TELEMETRY_POLICIES]; // Jobs and requests finished under each policy
+    long long deadlineMisses;
+    long long aperiodicServed;
+};
+
+struct Telemetry *telemetry_create(const char *name, int policy);
+struct Telemetry *telemetry_attach(const char *name);
+void telemetry_begin_write(struct Telemetry *telemetry);
+void telemetry_end_write(struct Telemetry *telemetry);
+void telemetry_read(const struct Telemetry *telemetry, struct Telemetry *snapshot);
+void telemetry_destroy(struct Telemetry *telemetry, const char *name);
+void telemetry_detach(struct Telemetry *telemetry);
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include "telemetry.h"
+
+// Attach to the telemetry segment of a running simulation and print its rates.
+// Only reads the segment, so the simulation never waits for the viewer.
+//
+// Usage: ./telemetry_view [interval_ms] [segment_name]
+
+static const char *policyString[TELEMETRY_POLICIES] = {
+    "FCFS", "SPN", "RR", "HRRN", "SRT", "FEED", "FP", "EDF"};
+
+int main(int argc, char *argv[])
+{
+    int intervalMs = argc > 1 ? atoi(argv[1]) : 1000;
+    const char *name = argc > 2 ? argv[2] : TELEMETRY_NAME;
+
+    if (intervalMs <= 0)
+        intervalMs = 1000;
+
+    struct Telemetry *telemetry = telemetry_attach(name);
+    if (telemetry == NULL)
+    {
+        fprintf(stderr, "No simulation is publishing telemetry at %s\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    struct Telemetry previous, current;
+    telemetry_read(telemetry, &previous);
+    double seconds = intervalMs / 1000.0;
+
+    printf("%12s %12s %8s %12s %10s %10s\n", "time", "time/s", "ready", "done/s", "misses", "aperiodic");
+    while (1)
+    {
+        usleep(intervalMs * 1000);
+        telemetry_read(telemetry, &current);
+
+        long long completed = 0, completedBefore = 0;
+        for (int p = 0; p < TELEMETRY_POLICIES; p++)
+        {
+            completed += current.completed[p];
+            completedBefore += previous.completed[p];
+        }
+
+        printf("%12lld %12.0f %8lld %12.1f %10lld %10lld  %s\n", current.virtualTime,
+               (current.virtualTime - previous.virtualTime) / seconds, current.readyQueueLength,
+               (completed - completedBefore) / seconds, current.deadlineMisses, current.aperiodicServed,
+               current.policy >= 0 && current.policy < TELEMETRY_POLICIES ? policyString[current.policy] : "?");
+        fflush(stdout);
+
+        // Stop once the simulation has exited
+        if (kill(current.pid, 0) != 0 && errno == ESRCH)
+            break;
+        previous = current;
+    }
+
+    telemetry_detach(telemetry);
+    return 0;
+}